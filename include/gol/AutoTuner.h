@@ -0,0 +1,64 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#ifndef GAMEOFLIFE_AUTOTUNER_H
+#define GAMEOFLIFE_AUTOTUNER_H
+
+#include "GridArena.h"
+#include "config.h"
+#include <string>
+
+typedef struct {
+    int n_threads;
+    int tile_h;
+    int tile_w;
+    int kernel_variant;
+    double ms_per_step;
+    bool cached;
+} TuneResult;
+
+// Picks the number of threads, the tile shape and the kernel variant for a
+// Config by timing a short run of each candidate. Results are cached per
+// host, domain size and boundary type in a text file, so only the first run
+// on a machine pays for the calibration.
+class AutoTuner {
+  public:
+    AutoTuner(const std::string &cache_file = default_cache_file());
+
+    virtual ~AutoTuner();
+
+    // Writes the best settings into config. The cache is skipped if force
+    // is set.
+    TuneResult tune(Config *config, bool force = false);
+
+    // $HOME/.game-of-life-tune, or a file in the working directory.
+    static std::string default_cache_file();
+
+    static std::string to_string(const TuneResult &result);
+
+  private:
+    std::string cache_file;
+    // Shared by the kernels of all candidates, so the grid is mapped once.
+    GridArena arena;
+
+    std::string cache_key(const Config &config) const;
+
+    bool load(const std::string &key, TuneResult *result) const;
+
+    void store(const std::string &key, const TuneResult &result) const;
+
+    double measure(Config config);
+};
+
+#endif
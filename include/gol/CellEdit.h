@@ -0,0 +1,28 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#ifndef GAMEOFLIFE_CELLEDIT_H
+#define GAMEOFLIFE_CELLEDIT_H
+
+#include <cstdint>
+
+// A cell set from outside the simulation, e.g. painted in the GUI. Edits
+// are applied in order, so a later edit of the same cell wins.
+typedef struct {
+    int64_t row;
+    int64_t col;
+    int value;
+} CellEdit;
+
+#endif
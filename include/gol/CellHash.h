@@ -0,0 +1,49 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#ifndef GAMEOFLIFE_CELLHASH_H
+#define GAMEOFLIFE_CELLHASH_H
+
+#include <cstdint>
+
+// The hash of a grid is computed row by row: every live cell adds the key of
+// its column to the sum of its row, and the mixed row sums of all non-empty
+// rows are XOR-ed together. The sums can be split over any column range and
+// the rows over any row range, so every thread hashes its own part of the
+// domain while stepping and the parts are combined afterwards. The inner
+// loop is a masked add, which vectorizes.
+inline uint64_t mix64(uint64_t z) {
+    // splitmix64 finalizer
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+inline uint64_t column_key(int64_t col) {
+    return mix64((uint64_t)col + 0x9e3779b97f4a7c15ULL);
+}
+
+// Returns the column key if the cell is alive and 0 otherwise, without
+// branching on the cell value.
+inline uint64_t cell_term(uint64_t key, int value) {
+    return key & (0 - (uint64_t)(value != 0));
+}
+
+inline uint64_t row_hash(int64_t row, uint64_t row_sum) {
+    if (row_sum == 0)
+        return 0;
+    return mix64(row_sum ^ mix64((uint64_t)row * 0xd6e8feb86659fd93ULL));
+}
+
+#endif
@@ -0,0 +1,113 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#ifndef GAMEOFLIFE_CHUNKEDUNIVERSE_H
+#define GAMEOFLIFE_CHUNKEDUNIVERSE_H
+
+#include "CellEdit.h"
+#include <cstdint>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#define CHUNK_SIZE 64
+// Number of generations a chunk must stay empty before it is freed, so that
+// oscillators on a chunk edge don't allocate and free it all the time.
+#define CHUNK_FREE_AFTER 16
+
+// Inclusive bounding box in grid coordinates. Empty if min > max.
+typedef struct {
+    int64_t min_row;
+    int64_t min_col;
+    int64_t max_row;
+    int64_t max_col;
+} Extent;
+
+typedef struct Chunk {
+    int64_t ci;
+    int64_t cj;
+    // Double buffered cells, cells[front] is the current generation.
+    uint8_t cells[2][CHUNK_SIZE * CHUNK_SIZE];
+    int front;
+    uint64_t col_keys[CHUNK_SIZE];
+    uint64_t row_sums[CHUNK_SIZE];
+    struct Chunk *neighbors[8];
+    long population;
+    int empty_generations;
+    Extent extent;
+} Chunk;
+
+// An unbounded grid, stored as a map of fixed size chunks. A chunk is
+// allocated as soon as a live cell touches its edge and freed once it has
+// been empty for a while, so the memory follows the live population instead
+// of its bounding box.
+class ChunkedUniverse {
+  public:
+    ChunkedUniverse(int n_threads);
+
+    virtual ~ChunkedUniverse();
+
+    void timestep();
+
+    void set_cell(int64_t row, int64_t col, int value);
+
+    // Applies a batch of edits; only the touched chunks are updated.
+    void set_cells(const std::vector<CellEdit> &edits);
+
+    // Loads a window of cells starting at (row, col) from xt.
+    void copy_from(int **xt, int64_t row, int64_t col, int rows, int cols);
+
+    int get_cell(int64_t row, int64_t col) const;
+
+    // Copies the window starting at (row, col) into xt.
+    void copy_to(int **xt, int64_t row, int64_t col, int rows, int cols) const;
+
+    long get_population() const;
+
+    uint64_t get_hash() const;
+
+    long get_n_chunks() const;
+
+    // Bounding box of the live cells.
+    Extent get_extent() const;
+
+  private:
+    int n_threads;
+    std::thread *threads;
+    std::unordered_map<uint64_t, Chunk *> chunks;
+    std::vector<Chunk *> chunk_list;
+    long population;
+    uint64_t hash;
+    Extent extent;
+
+    Chunk *find_chunk(int64_t ci, int64_t cj) const;
+
+    Chunk *get_or_create_chunk(int64_t ci, int64_t cj);
+
+    void grow();
+
+    void link_neighbors();
+
+    void timestep_chunks(const int min_chunk, const int max_chunk);
+
+    void timestep_chunk(Chunk *chunk);
+
+    void update_chunk_stats(Chunk *chunk, const uint8_t *cells);
+
+    void shrink();
+
+    void update_stats();
+};
+
+#endif
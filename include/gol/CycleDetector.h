@@ -0,0 +1,56 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#ifndef GAMEOFLIFE_CYCLEDETECTOR_H
+#define GAMEOFLIFE_CYCLEDETECTOR_H
+
+#include <cstdint>
+#include <vector>
+
+#define CYCLE_HISTORY_SIZE 64
+
+// Keeps a ring of the most recent grid hashes and reports a cycle of period P
+// once the last 2P generations consist of two identical periods. A period of
+// 1 means the grid has become a still life.
+class CycleDetector {
+  public:
+    CycleDetector(int capacity = CYCLE_HISTORY_SIZE);
+
+    void reset();
+
+    void push(uint64_t hash);
+
+    // Returns the confirmed period, or 0 if no cycle has been found (yet).
+    int get_period() const;
+
+    // Returns the generation at which the cycle was confirmed, or -1.
+    long get_confirmed_at() const;
+
+    // Returns the first generation of the cycle that is still in the
+    // history, or -1 if no cycle has been found.
+    long get_cycle_start() const;
+
+  private:
+    std::vector<uint64_t> ring;
+    long count;
+    int period;
+    long confirmed_at;
+    long cycle_start;
+
+    uint64_t at(long generation) const;
+
+    bool is_cycle(int p) const;
+};
+
+#endif
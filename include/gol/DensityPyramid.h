@@ -0,0 +1,74 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#ifndef GAMEOFLIFE_DENSITYPYRAMID_H
+#define GAMEOFLIFE_DENSITYPYRAMID_H
+
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+// Coarsest level: blocks of 2^15 x 2^15 cells, whose counts still fit in
+// 32 bits.
+const int PYRAMID_MAX_LEVEL = 15;
+
+// Live cell counts of a grid per block of 2x2, 4x4, 8x8, ... cells, so a
+// view of a grid much larger than the screen can be drawn in time
+// proportional to the number of pixels. Level k holds the blocks of
+// 2^k x 2^k cells; blocks at the bottom and right edge are cut off by the
+// domain. After cells change, mark() the changed rectangles and update():
+// only the blocks over them, and their parents, are recounted.
+class DensityPyramid {
+  public:
+    DensityPyramid(int rows, int cols);
+
+    virtual ~DensityPyramid();
+
+    // Marks the cells in [min_row, max_row) x [min_col, max_col) as
+    // changed.
+    void mark(int min_row, int min_col, int max_row, int max_col);
+
+    // Recounts the marked blocks from the cells.
+    void update(int **xt);
+
+    int get_levels() const;
+
+    int get_level_rows(int level) const;
+
+    int get_level_cols(int level) const;
+
+    // Live cells in block (row, col) of a level, 1 <= level <= levels.
+    uint32_t get_count(int level, int row, int col) const;
+
+    // Fraction of live cells per output pixel, for the whole domain shown
+    // in out_rows x out_cols pixels, written row by row to density. Uses
+    // the coarsest level whose blocks are not larger than a pixel, so a
+    // pixel sums a few blocks unless the domain is scaled very differently
+    // in the two directions. For domains less than twice as large as the
+    // output, pixels share the 2x2 blocks.
+    void sample(int out_rows, int out_cols, float *density) const;
+
+  private:
+    int rows;
+    int cols;
+    int levels;
+    // Index level - 1.
+    std::vector<int> level_rows;
+    std::vector<int> level_cols;
+    std::vector<std::vector<uint32_t>> counts;
+    // Changed cell rectangles as min_row, min_col, max_row, max_col.
+    std::vector<std::tuple<int, int, int, int>> marked;
+};
+
+#endif
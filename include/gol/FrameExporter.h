@@ -0,0 +1,99 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#ifndef GAMEOFLIFE_FRAMEEXPORTER_H
+#define GAMEOFLIFE_FRAMEEXPORTER_H
+
+#include "config.h"
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum EXPORT_FORMATS {
+    EXPORT_PPM = 0,
+    EXPORT_PNG = 1,
+    EXPORT_RAW = 2
+};
+
+typedef struct {
+    long index;
+    long generation;
+    std::vector<uint8_t> cells;
+} ExportJob;
+
+// Renders generations to image files, or to raw RGB frames on the stdin of
+// an encoder, with the zoom factor and colors of the GUI. push() only copies
+// the grid; rendering and encoding run on a pool of worker threads, so they
+// overlap with the next time steps. The queue is bounded, so a slow disk or
+// encoder slows the simulation down instead of filling the memory.
+class FrameExporter {
+  public:
+    // For EXPORT_RAW, output is a shell command that reads the frames from
+    // stdin, otherwise it is the directory for the image files.
+    FrameExporter(Config config, int format, const std::string &output);
+
+    virtual ~FrameExporter();
+
+    void push(int **xt, long generation);
+
+    // Waits until all frames are written.
+    void finish();
+
+    long get_n_frames() const;
+
+    int get_frame_w() const;
+
+    int get_frame_h() const;
+
+  private:
+    Config config;
+    int format;
+    std::string output;
+    int frame_w;
+    int frame_h;
+    FILE *pipe;
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable queue_changed;
+    std::deque<ExportJob> queue;
+    size_t max_queue;
+    bool stopping;
+    long n_frames;
+    std::mutex pipe_mutex;
+    // Rendered raw frames that wait for their predecessors, so the pipe
+    // receives them in order.
+    std::map<long, std::vector<uint8_t>> pending;
+    long next_to_write;
+
+    void work();
+
+    void render_rgb(const ExportJob &job, std::vector<uint8_t> &rgb) const;
+
+    void write_ppm(const ExportJob &job) const;
+
+    void write_png(const ExportJob &job) const;
+
+    void write_raw(const ExportJob &job);
+
+    std::string frame_filename(const ExportJob &job,
+                               const std::string &extension) const;
+};
+
+#endif
@@ -0,0 +1,85 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#ifndef GAMEOFLIFE_GAMEOFLIFEENSEMBLE_H
+#define GAMEOFLIFE_GAMEOFLIFEENSEMBLE_H
+
+#include "CycleDetector.h"
+#include "config.h"
+#include <cstdint>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+typedef struct {
+    unsigned int seed;
+    long population;
+    int period;
+    long stabilized_at;
+} UniverseStats;
+
+// Steps many independent universes of the same size in lockstep. The cells
+// are stored universe-innermost (structure of arrays), so the neighbor sum of
+// one cell is computed for a whole range of universes in a single,
+// vectorizable loop. Each universe has a halo of one cell on every side that
+// is filled from the boundary type before every step.
+class GameOfLifeEnsemble {
+  public:
+    GameOfLifeEnsemble(Config config, int n_universes, unsigned int seed);
+
+    virtual ~GameOfLifeEnsemble();
+
+    void timestep();
+
+    // Steps until all universes have settled in a cycle or n_steps is reached.
+    void run(int n_steps);
+
+    bool all_settled() const;
+
+    int get_n_universes() const;
+
+    int get_n_threads() const;
+
+    long get_generation() const;
+
+    UniverseStats get_stats(int universe) const;
+
+    int get_xt_at(int universe, int row, int col) const;
+
+  private:
+    Config config;
+    int n_universes;
+    unsigned int seed;
+    int padded_cols;
+    std::vector<uint8_t> xt0;
+    std::vector<uint8_t> xt1;
+    std::vector<uint64_t> hashes;
+    std::vector<long> populations;
+    std::vector<CycleDetector> cycle_detectors;
+    std::vector<std::tuple<int, int>> batches;
+    std::thread *threads;
+    long generation;
+
+    size_t index(int row, int col) const;
+
+    void set_initial_conditions();
+
+    void apply_boundary_conditions(const int min_u, const int max_u);
+
+    void timestep_universes(const int min_u, const int max_u);
+
+    void batch_ranges(int n_samples, int n_batches);
+};
+
+#endif
@@ -15,7 +15,18 @@
 #ifndef GAMEOFLIFE_GAMEOFLIFEKERNEL_H
 #define GAMEOFLIFE_GAMEOFLIFEKERNEL_H
 
+#include "CellEdit.h"
+#include "ChunkedUniverse.h"
+#include "CycleDetector.h"
+#include "DensityPyramid.h"
+#include "GridArena.h"
+#include "GridSnapshot.h"
+#include "SparseUniverse.h"
 #include "config.h"
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <tuple>
@@ -27,27 +38,112 @@
 enum BOUNDARY_TYPES {
     BOUNDARY_CONSTANT = 0,
     BOUNDARY_PERIODIC = 1,
-    BOUNDARY_MIRROR = 2
+    BOUNDARY_MIRROR = 2,
+    BOUNDARY_UNBOUNDED = 3
 };
 
+enum KERNEL_VARIANTS {
+    KERNEL_GENERIC = 0,
+    KERNEL_SPECIALIZED = 1
+};
+
+enum AUTOTUNE_MODES {
+    AUTOTUNE_OFF = 0,
+    AUTOTUNE_CACHED = 1,
+    AUTOTUNE_FORCE = 2
+};
+
+enum CYCLE_ACTIONS {
+    CYCLE_CONTINUE = 0,
+    CYCLE_STOP = 1,
+    CYCLE_FAST_FORWARD = 2
+};
+
+// Default edge length of the tiles of the specialized kernel, which only
+// steps the tiles that can change. Config::tile_h and tile_w override it.
+const int KERNEL_TILE_SIZE = 64;
+
+// Offset in bytes between the page-rounded end of the first cell buffer and
+// the start of the second: 17 cache lines.
+const size_t KERNEL_BUFFER_STAGGER = 17 * 64;
+
 class GameOfLifeKernel {
   public:
-    GameOfLifeKernel(Config config);
+    // The cell buffers are taken from the arena, which must outlive the
+    // kernel. Without an arena the kernel maps its own.
+    GameOfLifeKernel(Config config, GridArena *arena = nullptr);
 
     virtual ~GameOfLifeKernel();
 
     void timestep();
 
+    // Computes n generations on another thread. Until the future is ready,
+    // only edit() may be called; get() returns the new generation number.
+    std::future<long> step_async(int n = 1);
+
     int get_n_threads();
 
     int get_n_cpus();
 
     int **get_xt() const;
 
+    // The current generation as one block of rows, stride apart. The
+    // pointer is valid until the next time step.
+    const int *get_buffer(int *stride) const;
+
+    int get_rows() const;
+
+    int get_cols() const;
+
     const int get_xt_at(int row, int col);
 
+    // Copies the current generation into a snapshot, which is resized if
+    // needed.
+    void take_snapshot(GridSnapshot *snapshot) const;
+
+    std::shared_ptr<const GridSnapshot> snapshot() const;
+
+    // Replaces the cells and the generation number, e.g. with a generation
+    // from a HistoryBuffer. The cycle detector starts over. With
+    // BOUNDARY_UNBOUNDED the universe is replaced by the viewport, so the
+    // cells outside it are lost.
+    void set_state(int **cells, long generation);
+
+    // Queues a cell edit; safe to call from any thread. Queued edits are
+    // applied at the start of the next time step, or by apply_edits().
+    void edit(int64_t row, int64_t col, int value);
+
+    // Applies the queued edits to the current generation and returns their
+    // number. Called by the thread that steps the kernel.
+    int apply_edits();
+
+    // Appends every edit that is applied from now on to log, in the order
+    // they were queued; nullptr stops the logging. Set by the thread that
+    // steps the kernel.
+    void set_edit_log(std::vector<CellEdit> *log);
+
+    // Live cell counts per block of the current generation, brought up to
+    // date with the tiles that changed since the last call. nullptr unless
+    // Config::density_pyramid is set.
+    const DensityPyramid *get_pyramid();
+
     std::string to_string();
 
+    long get_generation() const;
+
+    long get_population() const;
+
+    uint64_t get_hash() const;
+
+    // Period of the cycle the grid has settled in, 1 for a still life and 0
+    // if no cycle has been detected.
+    int get_period() const;
+
+    // Bounding box of the live cells, with min_row > max_row if there are
+    // none. With BOUNDARY_UNBOUNDED it can extend beyond the domain, which
+    // is then a viewport at (0, 0).
+    Extent get_extent() const;
+
   private:
     Config config;
     /* int rows; */
@@ -55,8 +151,51 @@ class GameOfLifeKernel {
     std::thread *threads;
     int **xt0;
     int **xt1;
+    int *data0;
+    int *data1;
+    GridArena *arena;
+    bool owns_arena;
     int n_cpus;
+    void (GameOfLifeKernel::*fpr_timestep_subdomain)(int, int);
     void (GameOfLifeKernel::*fpr_apply_boundary_conditions)();
+    long generation;
+    // Hash sum and population per row of xt1, written by the thread that
+    // owns the row while stepping.
+    std::vector<uint64_t> col_keys;
+    std::vector<uint64_t> row_sums;
+    std::vector<long> row_populations;
+    uint64_t hash;
+    long population;
+    CycleDetector cycle_detector;
+    // Storage of the cells with BOUNDARY_UNBOUNDED, otherwise nullptr.
+    ChunkedUniverse *universe;
+    // Engine for low densities, used instead of the dense sweep while the
+    // density is below config.sparse_density. While it is active, xt0 is
+    // only filled in when it is read.
+    SparseUniverse *sparse;
+    bool sparse_active;
+    mutable bool dense_stale;
+    std::mutex edit_mutex;
+    std::vector<CellEdit> queued_edits;
+    std::vector<CellEdit> *edit_log;
+    std::vector<CellEdit> pending_edits;
+    // Tiles of the specialized kernel. A tile is stepped if it or one of
+    // its neighbors changed in the previous generation or was edited.
+    // Otherwise xt1, which holds the previous generation, already has the
+    // result, so xt1 is not cleared between steps. The hash sums and
+    // populations of the row segments of a tile are kept while it rests.
+    int tile_h;
+    int tile_w;
+    int tile_rows;
+    int tile_cols;
+    std::vector<uint8_t> tile_changed;
+    std::vector<uint8_t> tile_active;
+    std::vector<uint8_t> segment_changed;
+    std::vector<uint64_t> segment_sums;
+    std::vector<long> segment_populations;
+    // Tiles that changed since the pyramid was last updated.
+    DensityPyramid *pyramid;
+    std::vector<uint8_t> pyramid_tiles;
 
     std::vector<std::tuple<int, int>> batches;
 
@@ -67,12 +206,40 @@ class GameOfLifeKernel {
 
     void timestep_subdomain(const int min_row, const int max_row);
 
+    void timestep_subdomain_specialized(const int min_row, const int max_row);
+
+    template <int BT> void apply_specialized_boundary_conditions();
+
+    void select_kernel();
+
+    void timestep_unbounded();
+
+    void select_engine();
+
+    void timestep_sparse();
+
+    void sync_dense() const;
+
+    void mark_tile_changed(int row, int col);
+
+    void mark_all_tiles_changed();
+
+    void update_active_tiles();
+
+    void update_changed_tiles();
+
+    void update_pyramid_tiles();
+
     void apply_constant_boundary_conditions();
 
     void apply_periodic_boundary_conditions();
 
     void apply_mirror_boundary_conditions();
 
+    void hash_boundary();
+
+    void update_hash();
+
     void fx(const int i, const int j, const int sum);
 
     void start_no_threads(void (GameOfLifeKernel::*fn)(int, int),
@@ -84,6 +251,8 @@ class GameOfLifeKernel {
     void zeros(int **X);
 
     void batch_ranges(int n_samples, int n_batches);
+
+    int batch_index(int min_row) const;
 };
 
 #endif
\ No newline at end of file
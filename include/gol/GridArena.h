@@ -0,0 +1,65 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#ifndef GAMEOFLIFE_GRIDARENA_H
+#define GAMEOFLIFE_GRIDARENA_H
+
+#include <cstddef>
+
+enum ARENA_BACKINGS {
+    ARENA_NONE = 0,
+    ARENA_HEAP = 1,
+    ARENA_PAGES = 2,
+    ARENA_TRANSPARENT_HUGE_PAGES = 3,
+    ARENA_HUGETLB = 4
+};
+
+// One block of memory for the cell buffers of a kernel. On Linux it is
+// mapped with MAP_HUGETLB if huge pages are reserved, and otherwise with
+// regular pages aligned to 2 MB and advised for transparent huge pages, so
+// a large grid needs few TLB entries. An arena can be handed to the next
+// kernel: the block is kept as long as it is large enough, so a kernel
+// re-initialization does not map and fault in the memory again. An arena
+// serves one kernel at a time.
+class GridArena {
+  public:
+    GridArena(bool huge_pages = true);
+
+    virtual ~GridArena();
+
+    // Returns a block of at least the given number of bytes. The contents
+    // are undefined, unless is_zeroed() is true.
+    void *acquire(size_t bytes);
+
+    // Unmaps the block.
+    void release();
+
+    // True if the last acquired block is freshly mapped and all zeros.
+    bool is_zeroed() const;
+
+    int get_backing() const;
+
+    size_t get_capacity() const;
+
+    static const char *backing_name(int backing);
+
+  private:
+    bool huge_pages;
+    char *base;
+    size_t capacity;
+    int backing;
+    bool zeroed;
+};
+
+#endif
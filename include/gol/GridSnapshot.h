@@ -0,0 +1,68 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#ifndef GAMEOFLIFE_GRIDSNAPSHOT_H
+#define GAMEOFLIFE_GRIDSNAPSHOT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Read-only copy of one generation of a kernel, so it can be drawn or
+// printed while the kernel computes the next generations. Filled in by
+// GameOfLifeKernel::take_snapshot().
+class GridSnapshot {
+  public:
+    GridSnapshot(int rows = 0, int cols = 0);
+
+    virtual ~GridSnapshot();
+
+    long get_generation() const;
+
+    long get_population() const;
+
+    uint64_t get_hash() const;
+
+    int get_period() const;
+
+    int get_rows() const;
+
+    int get_cols() const;
+
+    int get_xt_at(int row, int col) const;
+
+    // Row pointers in the layout of GameOfLifeKernel::get_xt(). The cells
+    // must not be written.
+    int **get_xt() const;
+
+    const int *get_buffer(int *stride) const;
+
+    std::string to_string() const;
+
+  private:
+    friend class GameOfLifeKernel;
+
+    int rows;
+    int cols;
+    long generation;
+    long population;
+    uint64_t hash;
+    int period;
+    std::vector<int> cells;
+    std::vector<int *> xt;
+
+    void resize(int rows, int cols);
+};
+
+#endif
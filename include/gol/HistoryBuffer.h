@@ -0,0 +1,90 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#ifndef GAMEOFLIFE_HISTORYBUFFER_H
+#define GAMEOFLIFE_HISTORYBUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+const int HISTORY_KEYFRAME_INTERVAL = 64;
+
+typedef struct {
+    long generation;
+    bool key;
+    // Run-length coded bit-packed grid for a keyframe, or its XOR with the
+    // previous entry for a delta.
+    std::vector<uint8_t> data;
+} HistoryEntry;
+
+// Bounded history of generations, so a run can be stepped back and
+// scrubbed. Every keyframe_interval-th entry holds a full grid, the others
+// only their difference with the previous generation. When the memory cap
+// is reached the oldest keyframe is dropped together with its deltas. A
+// generation is rebuilt from the keyframe before it, so restoring costs at
+// most keyframe_interval delta decodes.
+class HistoryBuffer {
+  public:
+    HistoryBuffer(int rows, int cols, size_t max_bytes,
+                  int keyframe_interval = HISTORY_KEYFRAME_INTERVAL);
+
+    virtual ~HistoryBuffer();
+
+    // Appends a generation. Retained generations at or after it are
+    // dropped first, so the history continues from a restored state.
+    void push(int **xt, long generation);
+
+    // Writes the cells of a retained generation into xt, returns false if
+    // the generation is not retained.
+    bool restore(long generation, int **xt);
+
+    // Drops all generations after the given one.
+    void truncate_after(long generation);
+
+    // Oldest and newest retained generation, -1 if the history is empty.
+    long get_first_generation() const;
+
+    long get_last_generation() const;
+
+    size_t get_bytes() const;
+
+  private:
+    int rows;
+    int cols;
+    int words_per_row;
+    size_t max_bytes;
+    int keyframe_interval;
+    std::deque<HistoryEntry> entries;
+    size_t bytes;
+    // Entries since the last keyframe.
+    int since_key;
+    // Bit-packed cells of the newest entry, the base of the next delta.
+    std::vector<uint64_t> last;
+    std::vector<uint64_t> packed;
+
+    void pack(int **xt, std::vector<uint64_t> &out) const;
+
+    void unpack(const std::vector<uint64_t> &in, int **xt) const;
+
+    // Rebuilds the cells of entries[index] into out.
+    void decode(size_t index, std::vector<uint64_t> &out) const;
+
+    size_t find(long generation) const;
+
+    void evict();
+};
+
+#endif
@@ -0,0 +1,90 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#ifndef GAMEOFLIFE_KERNELS_H
+#define GAMEOFLIFE_KERNELS_H
+
+#include "GameOfLifeKernel.h"
+
+// Stepping functions templated on boundary type, rule and cell storage. The
+// kernel picks one instantiation at construction, after which the compiler
+// sees the whole neighbor loop and can inline the rule and vectorize it.
+
+// Computes the inner cells 1 .. cols - 2 of one row.
+template <typename Rule, typename Cell>
+inline void step_row(const Cell *__restrict up, const Cell *__restrict row,
+                     const Cell *__restrict down, Cell *__restrict out,
+                     const int cols) {
+    for (int j = 1; j < cols - 1; j++) {
+        int sum = up[j - 1] + up[j] + up[j + 1] + row[j - 1] + row[j + 1] +
+                  down[j - 1] + down[j] + down[j + 1];
+        out[j] = Rule::next(row[j], sum);
+    }
+}
+
+// Maps an index just outside [0, n) back into the domain.
+template <int BT> inline int boundary_index(const int k, const int n) {
+    if (BT == BOUNDARY_MIRROR) {
+        return (k < 0) ? 1 : ((k >= n) ? n - 2 : k);
+    }
+    return (k < 0) ? n - 1 : ((k >= n) ? 0 : k);
+}
+
+// Neighbor sum of a cell on the perimeter of the domain.
+template <int BT, typename Cell>
+inline int boundary_sum(const Cell *const *x, const int rows, const int cols,
+                        const int i, const int j) {
+    int sum = 0;
+    for (int di = -1; di <= 1; di++) {
+        for (int dj = -1; dj <= 1; dj++) {
+            if (di == 0 && dj == 0)
+                continue;
+            int r = i + di;
+            int c = j + dj;
+            if (BT == BOUNDARY_CONSTANT) {
+                if (r < 0 || r >= rows || c < 0 || c >= cols)
+                    continue;
+            } else {
+                r = boundary_index<BT>(r, rows);
+                c = boundary_index<BT>(c, cols);
+            }
+            sum += x[r][c];
+        }
+    }
+    if (BT == BOUNDARY_MIRROR && (i == 0 || i == rows - 1) &&
+        (j == 0 || j == cols - 1)) {
+        // The mirrored corners count the diagonal neighbor three times
+        // instead of four, as GameOfLifeKernel has always done.
+        sum -= x[(i == 0) ? 1 : rows - 2][(j == 0) ? 1 : cols - 2];
+    }
+    return sum;
+}
+
+// Computes all cells on the perimeter of the domain.
+template <int BT, typename Rule, typename Cell>
+inline void step_boundary(const Cell *const *x0, Cell *const *x1,
+                          const int rows, const int cols) {
+    for (int i = 1; i < rows - 1; i++) {
+        for (int j : {0, cols - 1}) {
+            x1[i][j] = Rule::next(x0[i][j], boundary_sum<BT>(x0, rows, cols, i, j));
+        }
+    }
+    for (int i : {0, rows - 1}) {
+        for (int j = 0; j < cols; j++) {
+            x1[i][j] = Rule::next(x0[i][j], boundary_sum<BT>(x0, rows, cols, i, j));
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,49 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#ifndef GAMEOFLIFE_PATTERNS_H
+#define GAMEOFLIFE_PATTERNS_H
+
+// Patterns that can be stamped into the domain, in plaintext format: 'O' is
+// a live cell, '.' a dead one and rows are separated by '\n'.
+typedef struct {
+    const char *name;
+    const char *cells;
+} Pattern;
+
+const Pattern PATTERNS[] = {
+    {"glider", ".O.\n"
+               "..O\n"
+               "OOO"},
+    {"lightweight spaceship", ".O..O\n"
+                              "O....\n"
+                              "O...O\n"
+                              "OOOO."},
+    {"r-pentomino", ".OO\n"
+                    "OO.\n"
+                    ".O."},
+    {"gosper glider gun", "........................O...........\n"
+                          "......................O.O...........\n"
+                          "............OO......OO............OO\n"
+                          "...........O...O....OO............OO\n"
+                          "OO........O.....O...OO..............\n"
+                          "OO........O...O.OO....O.O...........\n"
+                          "..........O.....O.......O...........\n"
+                          "...........O...O....................\n"
+                          "............OO......................"},
+};
+
+const int N_PATTERNS = sizeof(PATTERNS) / sizeof(PATTERNS[0]);
+
+#endif
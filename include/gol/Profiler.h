@@ -0,0 +1,95 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#ifndef GAMEOFLIFE_PROFILER_H
+#define GAMEOFLIFE_PROFILER_H
+
+// Scoped timers around the phases of a time step. Build with
+// -DGOL_PROFILING=ON to enable them; otherwise the macros expand to nothing
+// and no profiling code is compiled at all.
+#ifdef GOL_PROFILING
+
+#include <cstdint>
+#include <string>
+
+#define GOL_PROFILE_CONCAT_(a, b) a##b
+#define GOL_PROFILE_CONCAT(a, b) GOL_PROFILE_CONCAT_(a, b)
+// Times the enclosing scope on the calling thread.
+#define GOL_PROFILE_SCOPE(name)                                                \
+    ProfileScope GOL_PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+// Times the enclosing scope and reports it on the track of the given worker.
+#define GOL_PROFILE_WORKER(name, worker)                                       \
+    ProfileScope GOL_PROFILE_CONCAT(profile_scope_, __LINE__)(name, worker)
+
+typedef struct {
+    const char *name;
+    int track;
+    uint64_t start_ns;
+    uint64_t duration_ns;
+    int64_t cycles;
+    int64_t cache_misses;
+} ProfileEvent;
+
+class Profiler {
+  public:
+    // Starts recording. With counters, the cycles and cache misses of every
+    // scope are read with perf_event_open, if the OS allows it. Each thread
+    // opens its own counters, so short-lived worker threads add the setup
+    // to the span that starts and joins them.
+    static void enable(bool with_counters);
+
+    static bool is_enabled();
+
+    static bool has_counters();
+
+    static uint64_t now_ns();
+
+    static void record(const ProfileEvent &event);
+
+    // Writes all recorded events as Chrome trace JSON, which can be opened
+    // in chrome://tracing or https://ui.perfetto.dev.
+    static bool write_chrome_trace(const std::string &filename);
+};
+
+// Hardware counters of the calling thread.
+class PerfCounters {
+  public:
+    PerfCounters();
+    virtual ~PerfCounters();
+    bool is_open() const;
+    void read(int64_t *cycles, int64_t *cache_misses);
+
+  private:
+    int fd_cycles;
+    int fd_cache_misses;
+};
+
+class ProfileScope {
+  public:
+    ProfileScope(const char *name, int worker = -1);
+    virtual ~ProfileScope();
+
+  private:
+    ProfileEvent event;
+    bool active;
+};
+
+#else
+
+#define GOL_PROFILE_SCOPE(name)
+#define GOL_PROFILE_WORKER(name, worker)
+
+#endif
+
+#endif
@@ -0,0 +1,27 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#ifndef GAMEOFLIFE_RULES_H
+#define GAMEOFLIFE_RULES_H
+
+// Conway's rules (B3/S23) without branches: a cell is alive in the next
+// generation if it has 3 neighbors, or if it is alive and has 2 neighbors.
+struct ConwayRule {
+    template <typename Cell, typename Sum>
+    static inline Cell next(Cell value, Sum sum) {
+        return (Cell)((sum == 3) | (value & (sum == 2)));
+    }
+};
+
+#endif
@@ -0,0 +1,85 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#ifndef GAMEOFLIFE_RUNLENGTH_H
+#define GAMEOFLIFE_RUNLENGTH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Byte-wise run-length coding for bit-packed grids and their XOR deltas,
+// which are mostly zeros. Control byte c < 128 is followed by c + 1
+// literal bytes, c >= 128 stands for c - 127 zero bytes.
+inline void rle_encode(const uint8_t *in, size_t n,
+                       std::vector<uint8_t> &out) {
+    size_t i = 0;
+    while (i < n) {
+        size_t run = 1;
+        if (in[i] == 0) {
+            while (i + run < n && run < 128 && in[i + run] == 0)
+                run++;
+            out.push_back(127 + run);
+        } else {
+            while (i + run < n && run < 128 && in[i + run] != 0)
+                run++;
+            out.push_back(run - 1);
+            out.insert(out.end(), in + i, in + i + run);
+        }
+        i += run;
+    }
+}
+
+// Returns false if the input does not decode to exactly n bytes.
+inline bool rle_decode(const uint8_t *in, size_t length, uint8_t *out,
+                       size_t n) {
+    size_t j = 0;
+    for (size_t i = 0; i < length;) {
+        size_t c = in[i++];
+        if (c < 128) {
+            if (j + c + 1 > n || i + c + 1 > length)
+                return false;
+            for (size_t k = 0; k <= c; k++)
+                out[j++] = in[i++];
+        } else {
+            if (j + c - 127 > n)
+                return false;
+            for (size_t k = 0; k < c - 127; k++)
+                out[j++] = 0;
+        }
+    }
+    return j == n;
+}
+
+// Decodes a delta and applies it to out with XOR; zero runs are skipped.
+inline bool rle_decode_xor(const uint8_t *in, size_t length, uint8_t *out,
+                           size_t n) {
+    size_t j = 0;
+    for (size_t i = 0; i < length;) {
+        size_t c = in[i++];
+        if (c < 128) {
+            if (j + c + 1 > n || i + c + 1 > length)
+                return false;
+            for (size_t k = 0; k <= c; k++)
+                out[j++] ^= in[i++];
+        } else {
+            j += c - 127;
+            if (j > n)
+                return false;
+        }
+    }
+    return j == n;
+}
+
+#endif
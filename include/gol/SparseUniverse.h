@@ -0,0 +1,64 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#ifndef GAMEOFLIFE_SPARSEUNIVERSE_H
+#define GAMEOFLIFE_SPARSEUNIVERSE_H
+
+#include "CellEdit.h"
+#include <cstdint>
+#include <vector>
+
+// Stores only the live cells of a bounded domain, as a sorted array of packed
+// (row, col) coordinates. A step emits the 8 neighbor coordinates of every
+// live cell, sorts them and counts the runs, so the work is proportional to
+// the population instead of the area. Supports constant and periodic
+// boundaries with the same results as GameOfLifeKernel.
+class SparseUniverse {
+  public:
+    SparseUniverse(int rows, int cols, int boundary_type);
+
+    void load(int **xt);
+
+    void timestep();
+
+    // Writes the live cells into xt, without clearing it.
+    void set_in(int **xt) const;
+
+    // Clears the live cells in xt.
+    void clear_in(int **xt) const;
+
+    void set_cell(int row, int col, int value);
+
+    // Applies a batch of edits with one pass over the cells.
+    void set_cells(const std::vector<CellEdit> &edits);
+
+    long get_population() const;
+
+    uint64_t get_hash() const;
+
+  private:
+    int rows;
+    int cols;
+    int boundary_type;
+    std::vector<uint64_t> cells;
+    std::vector<uint64_t> next_cells;
+    std::vector<uint64_t> contributions;
+    uint64_t hash;
+
+    void add_contributions(uint64_t cell);
+
+    void update_hash();
+};
+
+#endif
@@ -0,0 +1,89 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#ifndef GAMEOFLIFE_STEPAHEAD_H
+#define GAMEOFLIFE_STEPAHEAD_H
+
+#include "CellEdit.h"
+#include "GameOfLifeKernel.h"
+#include "GridSnapshot.h"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class SnapshotPool;
+
+// Steps a kernel on a thread of its own, up to depth generations ahead of
+// the consumer, and hands out the generations in order as snapshots. A
+// snapshot stays valid as long as the consumer holds it; released
+// snapshots are reused for later generations, so after the first few
+// generations nothing is allocated.
+//
+// While a StepAhead runs, the kernel must only be used through edit(). Its
+// edits are applied at the next computed generation, so they show up as
+// many generations late as are queued. rewind() takes the kernel back to a
+// handed-out generation without losing them.
+class StepAhead {
+  public:
+    // Hands out the current generation of the kernel first. With
+    // last_generation >= 0 the stepping stops at that generation.
+    StepAhead(GameOfLifeKernel *kernel, int depth,
+              long last_generation = -1);
+
+    // Stops the stepping. The kernel is then at the newest computed
+    // generation, which can be ahead of the last one handed out.
+    virtual ~StepAhead();
+
+    // The next generation, blocks until it is computed. Returns nullptr
+    // after last_generation has been handed out.
+    std::shared_ptr<const GridSnapshot> next();
+
+    // Number of computed generations that have not been handed out.
+    int get_ready();
+
+    // Stops the stepping and sets the kernel to a handed-out generation,
+    // e.g. the one on screen. The edits that went into later generations,
+    // and those still queued, are queued again in their order, so the next
+    // apply_edits() applies them to that generation. No generations are
+    // handed out afterwards. A snapshot only holds the viewport, so with
+    // BOUNDARY_UNBOUNDED the cells outside it are lost, see set_state().
+    void rewind(const GridSnapshot &shown);
+
+  private:
+    GameOfLifeKernel *kernel;
+    int depth;
+    long last_generation;
+    std::shared_ptr<SnapshotPool> pool;
+    std::deque<std::shared_ptr<const GridSnapshot>> ready;
+    std::mutex mutex;
+    std::condition_variable room;
+    std::condition_variable filled;
+    bool stopping;
+    bool done;
+    std::thread worker;
+    // Edits logged by the kernel during the step in progress, and the edits
+    // per computed generation that has not been handed out.
+    std::vector<CellEdit> step_edits;
+    std::deque<std::pair<long, std::vector<CellEdit>>> applied_edits;
+
+    void run();
+
+    void stop();
+};
+
+#endif
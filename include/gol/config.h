@@ -25,6 +25,28 @@ typedef struct {
     int zoom_factor;
     bool with_threads;
     bool mode_fullscreen;
+    int on_cycle;
+    int ensemble_size;
+    unsigned int seed;
+    int kernel_variant;
+    float density;
+    float sparse_density;
+    bool quiet;
+    bool headless;
+    int export_format;
+    int export_every;
+    int history_mb;
+    // 0 = one thread per cpu core, and the default tile size.
+    int n_threads;
+    int tile_h;
+    int tile_w;
+    int autotune;
+    // Generations computed ahead of the display, 0 = off.
+    int step_ahead;
+    // Keep a DensityPyramid of the grid, for views of large domains.
+    bool density_pyramid;
+    // Cells per pixel in the GUI, 1 = every cell is drawn.
+    int zoom_out;
 } Config;
 
 #endif
@@ -0,0 +1,101 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#ifndef GAMEOFLIFE_GOL_C_H
+#define GAMEOFLIFE_GOL_C_H
+
+// C interface to the simulator, exported by the shared library gameoflife.
+// Only plain C types cross the boundary, so the ABI does not depend on the
+// C++ compiler or standard library of the caller. Functions that can fail
+// return a negative value or NULL and leave a message in gol_last_error().
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+#if defined(GOL_C_BUILD)
+#define GOL_API __declspec(dllexport)
+#else
+#define GOL_API __declspec(dllimport)
+#endif
+#else
+#define GOL_API __attribute__((visibility("default")))
+#endif
+
+// Incremented when a struct or function signature below changes.
+#define GOL_API_VERSION 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct gol_kernel gol_kernel;
+
+typedef struct {
+    int rows;
+    int cols;
+    // 0=const, 1=periodic, 2=mirror, 3=unbounded, see BOUNDARY_TYPES.
+    int boundary_type;
+    // 0=generic, 1=specialized, see KERNEL_VARIANTS.
+    int kernel_variant;
+    int with_threads;
+    // 0 picks a random seed.
+    unsigned int seed;
+    float density;
+    float sparse_density;
+} gol_config;
+
+typedef struct {
+    int64_t generation;
+    int64_t population;
+    uint64_t hash;
+    // 1 for a still life, 0 if no cycle has been detected.
+    int period;
+} gol_stats;
+
+// Called after every generation computed by gol_step. Returning non-zero
+// stops gol_step after the current generation.
+typedef int (*gol_callback)(gol_kernel *kernel, int64_t generation,
+                            void *user_data);
+
+GOL_API int gol_api_version(void);
+
+GOL_API gol_config gol_config_default(void);
+
+GOL_API gol_kernel *gol_create(const gol_config *config);
+
+GOL_API void gol_destroy(gol_kernel *kernel);
+
+// Computes up to n generations and returns the number computed, or -1.
+GOL_API int gol_step(gol_kernel *kernel, int n);
+
+GOL_API int gol_get_stats(const gol_kernel *kernel, gol_stats *stats);
+
+// Borrowed pointer to the current generation: rows of cols cells, one int
+// per cell, row r starting at buffer + r * stride. It stays valid until the
+// next gol_step or gol_destroy and must not be freed by the caller.
+GOL_API const int *gol_get_buffer(gol_kernel *kernel, int *rows, int *cols,
+                                  int *stride);
+
+// Replaces the callback, NULL removes it.
+GOL_API void gol_set_callback(gol_kernel *kernel, gol_callback callback,
+                              void *user_data);
+
+// Message of the last failed call on this thread, or an empty string.
+GOL_API const char *gol_last_error(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,224 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#include "gol/AutoTuner.h"
+#include "gol/GameOfLifeKernel.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+// The calibration runs on at most this many cells; larger domains are cut
+// to fewer rows of the same width.
+static const long TUNE_MAX_CELLS = 1L << 24;
+// Each candidate runs for at least this long and this many steps.
+static const double TUNE_MIN_MS = 20;
+static const int TUNE_MIN_STEPS = 5;
+static const int TUNE_MAX_STEPS = 1000;
+// Number of fields in the key of a line in the cache file.
+static const int TUNE_KEY_FIELDS = 6;
+
+static std::string host_name() {
+#if defined(_WIN32)
+    const char *name = std::getenv("COMPUTERNAME");
+    return name != nullptr ? name : "localhost";
+#else
+    char name[256];
+    if (gethostname(name, sizeof(name)) != 0)
+        return "localhost";
+    name[sizeof(name) - 1] = '\0';
+    return name;
+#endif
+}
+
+AutoTuner::AutoTuner(const std::string &cache_file_)
+    : cache_file(cache_file_) {}
+
+AutoTuner::~AutoTuner() {}
+
+std::string AutoTuner::default_cache_file() {
+    const char *home = std::getenv("HOME");
+#if defined(_WIN32)
+    if (home == nullptr)
+        home = std::getenv("USERPROFILE");
+#endif
+    if (home == nullptr)
+        return ".game-of-life-tune";
+    return std::string(home) + "/.game-of-life-tune";
+}
+
+std::string AutoTuner::to_string(const TuneResult &result) {
+    std::stringstream ss;
+    ss << "threads " << result.n_threads << ", ";
+    if (result.kernel_variant == KERNEL_SPECIALIZED)
+        ss << "tile " << result.tile_h << " x " << result.tile_w;
+    else
+        ss << "generic kernel";
+    ss << ", " << result.ms_per_step << " ms/step";
+    if (result.cached)
+        ss << " (cached)";
+    return ss.str();
+}
+
+std::string AutoTuner::cache_key(const Config &config) const {
+    std::stringstream ss;
+    ss << host_name() << " " << std::thread::hardware_concurrency() << " "
+       << config.rows << " " << config.cols << " " << config.boundary_type
+       << " " << config.with_threads;
+    return ss.str();
+}
+
+bool AutoTuner::load(const std::string &key, TuneResult *result) const {
+    std::ifstream file(cache_file);
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string field;
+        std::string line_key;
+        for (int k = 0; k < TUNE_KEY_FIELDS && fields >> field; k++)
+            line_key += (k > 0 ? " " : "") + field;
+        if (line_key != key)
+            continue;
+        TuneResult r;
+        if (fields >> r.n_threads >> r.tile_h >> r.tile_w >>
+            r.kernel_variant >> r.ms_per_step) {
+            r.cached = true;
+            *result = r;
+            return true;
+        }
+    }
+    return false;
+}
+
+void AutoTuner::store(const std::string &key, const TuneResult &result) const {
+    // Rewrite the file with the line for this key replaced.
+    std::vector<std::string> lines;
+    {
+        std::ifstream file(cache_file);
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.compare(0, key.size() + 1, key + " ") != 0)
+                lines.push_back(line);
+        }
+    }
+    std::stringstream ss;
+    ss << key << " " << result.n_threads << " " << result.tile_h << " "
+       << result.tile_w << " " << result.kernel_variant << " "
+       << result.ms_per_step;
+    lines.push_back(ss.str());
+    std::ofstream file(cache_file, std::ios::trunc);
+    for (const std::string &line : lines)
+        file << line << "\n";
+    if (!file)
+        std::cerr << "--- Can't write " << cache_file << std::endl;
+}
+
+double AutoTuner::measure(Config config) {
+    config.quiet = true;
+    config.sparse_density = 0;
+    config.autotune = AUTOTUNE_OFF;
+    if (config.seed == 0)
+        config.seed = 1;
+    const double full_cells = (double)config.rows * config.cols;
+    if (full_cells > TUNE_MAX_CELLS)
+        config.rows = std::max(64L, TUNE_MAX_CELLS / config.cols);
+    GameOfLifeKernel kernel(config, &arena);
+    kernel.timestep();
+    int steps = 0;
+    double ms = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    while (steps < TUNE_MIN_STEPS ||
+           (ms < TUNE_MIN_MS && steps < TUNE_MAX_STEPS)) {
+        kernel.timestep();
+        steps++;
+        auto t1 = std::chrono::steady_clock::now();
+        ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    }
+    // Scale back to the full domain.
+    return ms / steps * full_cells / ((double)config.rows * config.cols);
+}
+
+TuneResult AutoTuner::tune(Config *config, bool force) {
+    const std::string key = cache_key(*config);
+    TuneResult best;
+    if (!force && load(key, &best)) {
+        config->n_threads = best.n_threads;
+        config->tile_h = best.tile_h;
+        config->tile_w = best.tile_w;
+        config->kernel_variant = best.kernel_variant;
+        return best;
+    }
+    // Thread counts are powers of two up to the number of cores.
+    std::vector<int> thread_counts = {1};
+    int n_cpus = std::max(1u, std::thread::hardware_concurrency());
+    if (config->with_threads) {
+        for (int n = 2; n < n_cpus; n *= 2)
+            thread_counts.push_back(n);
+        if (n_cpus > 1)
+            thread_counts.push_back(n_cpus);
+    }
+    // Tile shapes of the specialized kernel; 0 x 0 stands for the generic
+    // kernel, which has no tiles.
+    std::vector<std::pair<int, int>> tiles = {
+        {0, 0}, {32, 32}, {64, 64}, {128, 128}, {16, 256}, {64, 256}};
+    if (config->boundary_type == BOUNDARY_UNBOUNDED)
+        tiles = {{0, 0}};
+    best.ms_per_step = -1;
+    best.cached = false;
+    for (int n_threads : thread_counts) {
+        for (auto &tile : tiles) {
+            Config candidate = *config;
+            candidate.n_threads = n_threads;
+            candidate.tile_h = tile.first;
+            candidate.tile_w = tile.second;
+            candidate.kernel_variant =
+                tile.first == 0 ? KERNEL_GENERIC : KERNEL_SPECIALIZED;
+            if (config->boundary_type == BOUNDARY_UNBOUNDED)
+                candidate.kernel_variant = config->kernel_variant;
+            double ms = measure(candidate);
+            if (!config->quiet) {
+                std::cout << "--- Autotune: threads " << std::setw(3)
+                          << n_threads << ", ";
+                if (tile.first == 0)
+                    std::cout << "generic kernel     ";
+                else
+                    std::cout << "tile " << std::setw(3) << tile.first
+                              << " x " << std::setw(3) << tile.second
+                              << "   ";
+                std::cout << ": " << ms << " ms/step" << std::endl;
+            }
+            if (best.ms_per_step < 0 || ms < best.ms_per_step) {
+                best.n_threads = n_threads;
+                best.tile_h = candidate.tile_h;
+                best.tile_w = candidate.tile_w;
+                best.kernel_variant = candidate.kernel_variant;
+                best.ms_per_step = ms;
+            }
+        }
+    }
+    store(key, best);
+    config->n_threads = best.n_threads;
+    config->tile_h = best.tile_h;
+    config->tile_w = best.tile_w;
+    config->kernel_variant = best.kernel_variant;
+    return best;
+}
@@ -0,0 +1,368 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#include "gol/ChunkedUniverse.h"
+#include "gol/CellHash.h"
+#include "gol/Kernels.h"
+#include "gol/Profiler.h"
+#include "gol/Rules.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+// Offsets of the 8 neighbors of a chunk, in the order of Chunk::neighbors.
+static const int neighbor_offsets[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1},
+                                           {0, 1},   {1, -1}, {1, 0},  {1, 1}};
+
+static int64_t floor_div(int64_t a, int64_t b) {
+    return (a >= 0) ? a / b : -((-a + b - 1) / b);
+}
+
+static uint64_t chunk_key(int64_t ci, int64_t cj) {
+    return ((uint64_t)(uint32_t)ci << 32) | (uint64_t)(uint32_t)cj;
+}
+
+static Extent empty_extent() {
+    Extent extent;
+    extent.min_row = std::numeric_limits<int64_t>::max();
+    extent.min_col = std::numeric_limits<int64_t>::max();
+    extent.max_row = std::numeric_limits<int64_t>::min();
+    extent.max_col = std::numeric_limits<int64_t>::min();
+    return extent;
+}
+
+ChunkedUniverse::ChunkedUniverse(int n_threads_)
+    : n_threads(n_threads_ < 1 ? 1 : n_threads_), population(0), hash(0),
+      extent(empty_extent()) {
+    threads = new std::thread[n_threads];
+}
+
+ChunkedUniverse::~ChunkedUniverse() {
+    for (Chunk *chunk : chunk_list) {
+        delete chunk;
+    }
+    delete[] threads;
+}
+
+void ChunkedUniverse::timestep() {
+    GOL_PROFILE_SCOPE("chunks");
+    grow();
+    link_neighbors();
+    const int n_chunks = chunk_list.size();
+    const int n_batches = std::min(n_threads, n_chunks);
+    if (n_batches <= 1) {
+        timestep_chunks(0, n_chunks);
+    } else {
+        const int batch_size = (n_chunks + n_batches - 1) / n_batches;
+        for (int t = 0; t < n_batches; t++) {
+            threads[t] = std::thread(&ChunkedUniverse::timestep_chunks, this,
+                                     t * batch_size,
+                                     std::min(n_chunks, (t + 1) * batch_size));
+        }
+        for (int t = 0; t < n_batches; t++) {
+            threads[t].join();
+        }
+    }
+    for (Chunk *chunk : chunk_list) {
+        chunk->front = 1 - chunk->front;
+    }
+    shrink();
+    update_stats();
+}
+
+void ChunkedUniverse::set_cell(int64_t row, int64_t col, int value) {
+    Chunk *chunk = get_or_create_chunk(floor_div(row, CHUNK_SIZE),
+                                       floor_div(col, CHUNK_SIZE));
+    int64_t r = row - chunk->ci * CHUNK_SIZE;
+    int64_t c = col - chunk->cj * CHUNK_SIZE;
+    chunk->cells[chunk->front][r * CHUNK_SIZE + c] = (value != 0);
+    update_chunk_stats(chunk, chunk->cells[chunk->front]);
+    update_stats();
+}
+
+void ChunkedUniverse::set_cells(const std::vector<CellEdit> &edits) {
+    std::vector<Chunk *> touched;
+    for (const CellEdit &edit : edits) {
+        Chunk *chunk = get_or_create_chunk(floor_div(edit.row, CHUNK_SIZE),
+                                           floor_div(edit.col, CHUNK_SIZE));
+        int64_t r = edit.row - chunk->ci * CHUNK_SIZE;
+        int64_t c = edit.col - chunk->cj * CHUNK_SIZE;
+        chunk->cells[chunk->front][r * CHUNK_SIZE + c] = (edit.value != 0);
+        if (touched.empty() || touched.back() != chunk)
+            touched.push_back(chunk);
+    }
+    std::sort(touched.begin(), touched.end());
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+    for (Chunk *chunk : touched)
+        update_chunk_stats(chunk, chunk->cells[chunk->front]);
+    update_stats();
+}
+
+int ChunkedUniverse::get_cell(int64_t row, int64_t col) const {
+    Chunk *chunk =
+        find_chunk(floor_div(row, CHUNK_SIZE), floor_div(col, CHUNK_SIZE));
+    if (chunk == nullptr)
+        return 0;
+    int64_t r = row - chunk->ci * CHUNK_SIZE;
+    int64_t c = col - chunk->cj * CHUNK_SIZE;
+    return chunk->cells[chunk->front][r * CHUNK_SIZE + c];
+}
+
+void ChunkedUniverse::copy_from(int **xt, int64_t row, int64_t col, int rows,
+                                int cols) {
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            if (xt[i][j] == 0)
+                continue;
+            Chunk *chunk = get_or_create_chunk(floor_div(row + i, CHUNK_SIZE),
+                                               floor_div(col + j, CHUNK_SIZE));
+            int64_t r = row + i - chunk->ci * CHUNK_SIZE;
+            int64_t c = col + j - chunk->cj * CHUNK_SIZE;
+            chunk->cells[chunk->front][r * CHUNK_SIZE + c] = 1;
+        }
+    }
+    for (Chunk *chunk : chunk_list) {
+        update_chunk_stats(chunk, chunk->cells[chunk->front]);
+    }
+    update_stats();
+}
+
+void ChunkedUniverse::copy_to(int **xt, int64_t row, int64_t col, int rows,
+                              int cols) const {
+    for (int i = 0; i < rows; i++) {
+        std::fill(xt[i], xt[i] + cols, 0);
+    }
+    for (const Chunk *chunk : chunk_list) {
+        if (chunk->population == 0)
+            continue;
+        const int64_t r0 = chunk->ci * CHUNK_SIZE;
+        const int64_t c0 = chunk->cj * CHUNK_SIZE;
+        const int64_t min_r = std::max(r0, row);
+        const int64_t max_r = std::min(r0 + CHUNK_SIZE, row + rows);
+        const int64_t min_c = std::max(c0, col);
+        const int64_t max_c = std::min(c0 + CHUNK_SIZE, col + cols);
+        const uint8_t *cells = chunk->cells[chunk->front];
+        for (int64_t r = min_r; r < max_r; r++) {
+            for (int64_t c = min_c; c < max_c; c++) {
+                xt[r - row][c - col] = cells[(r - r0) * CHUNK_SIZE + (c - c0)];
+            }
+        }
+    }
+}
+
+long ChunkedUniverse::get_population() const { return population; }
+
+uint64_t ChunkedUniverse::get_hash() const { return hash; }
+
+long ChunkedUniverse::get_n_chunks() const { return chunk_list.size(); }
+
+Extent ChunkedUniverse::get_extent() const { return extent; }
+
+Chunk *ChunkedUniverse::find_chunk(int64_t ci, int64_t cj) const {
+    auto it = chunks.find(chunk_key(ci, cj));
+    return (it == chunks.end()) ? nullptr : it->second;
+}
+
+Chunk *ChunkedUniverse::get_or_create_chunk(int64_t ci, int64_t cj) {
+    Chunk *chunk = find_chunk(ci, cj);
+    if (chunk != nullptr)
+        return chunk;
+    chunk = new Chunk();
+    chunk->ci = ci;
+    chunk->cj = cj;
+    chunk->front = 0;
+    for (int j = 0; j < CHUNK_SIZE; j++) {
+        chunk->col_keys[j] = column_key(cj * CHUNK_SIZE + j);
+    }
+    chunk->extent = empty_extent();
+    chunks[chunk_key(ci, cj)] = chunk;
+    chunk_list.push_back(chunk);
+    return chunk;
+}
+
+void ChunkedUniverse::grow() {
+    // Live cells on the edge of a chunk can give births in the neighboring
+    // chunk, which must exist before the step. Touching a chunk here also
+    // keeps it from being freed.
+    const int S = CHUNK_SIZE;
+    const size_t n_chunks = chunk_list.size();
+    for (size_t k = 0; k < n_chunks; k++) {
+        Chunk *chunk = chunk_list[k];
+        if (chunk->population == 0)
+            continue;
+        const uint8_t *c = chunk->cells[chunk->front];
+        bool top = false, bottom = false, left = false, right = false;
+        for (int t = 0; t < S; t++) {
+            top |= c[t] != 0;
+            bottom |= c[(S - 1) * S + t] != 0;
+            left |= c[t * S] != 0;
+            right |= c[t * S + S - 1] != 0;
+        }
+        bool needed[8] = {c[0] != 0,           top,
+                          c[S - 1] != 0,       left,
+                          right,               c[(S - 1) * S] != 0,
+                          bottom,              c[S * S - 1] != 0};
+        for (int n = 0; n < 8; n++) {
+            if (!needed[n])
+                continue;
+            Chunk *neighbor =
+                get_or_create_chunk(chunk->ci + neighbor_offsets[n][0],
+                                    chunk->cj + neighbor_offsets[n][1]);
+            neighbor->empty_generations = 0;
+        }
+    }
+}
+
+void ChunkedUniverse::link_neighbors() {
+    for (Chunk *chunk : chunk_list) {
+        for (int n = 0; n < 8; n++) {
+            chunk->neighbors[n] = find_chunk(chunk->ci + neighbor_offsets[n][0],
+                                             chunk->cj + neighbor_offsets[n][1]);
+        }
+    }
+}
+
+void ChunkedUniverse::timestep_chunks(const int min_chunk,
+                                      const int max_chunk) {
+    for (int k = min_chunk; k < max_chunk; k++) {
+        timestep_chunk(chunk_list[k]);
+    }
+}
+
+void ChunkedUniverse::timestep_chunk(Chunk *chunk) {
+    const int S = CHUNK_SIZE;
+    const int W = CHUNK_SIZE + 2;
+    // Gather the chunk and the edges of its neighbors in a padded buffer.
+    uint8_t halo[W * W];
+    std::memset(halo, 0, sizeof(halo));
+    const uint8_t *c = chunk->cells[chunk->front];
+    for (int r = 0; r < S; r++) {
+        std::memcpy(halo + (r + 1) * W + 1, c + r * S, S);
+    }
+    const uint8_t *n[8];
+    for (int k = 0; k < 8; k++) {
+        Chunk *neighbor = chunk->neighbors[k];
+        n[k] = (neighbor != nullptr) ? neighbor->cells[neighbor->front]
+                                     : nullptr;
+    }
+    if (n[0])
+        halo[0] = n[0][S * S - 1];
+    if (n[1])
+        std::memcpy(halo + 1, n[1] + (S - 1) * S, S);
+    if (n[2])
+        halo[W - 1] = n[2][(S - 1) * S];
+    for (int r = 0; r < S; r++) {
+        if (n[3])
+            halo[(r + 1) * W] = n[3][r * S + S - 1];
+        if (n[4])
+            halo[(r + 1) * W + W - 1] = n[4][r * S];
+    }
+    if (n[5])
+        halo[(W - 1) * W] = n[5][S - 1];
+    if (n[6])
+        std::memcpy(halo + (W - 1) * W + 1, n[6], S);
+    if (n[7])
+        halo[W * W - 1] = n[7][0];
+    // Step the chunk.
+    uint8_t *next = chunk->cells[1 - chunk->front];
+    uint8_t out[W];
+    for (int r = 1; r <= S; r++) {
+        step_row<ConwayRule>(halo + (r - 1) * W, halo + r * W,
+                             halo + (r + 1) * W, out, W);
+        std::memcpy(next + (r - 1) * S, out + 1, S);
+    }
+    // The stats are computed on the new generation, which becomes current
+    // after the swap.
+    update_chunk_stats(chunk, next);
+}
+
+void ChunkedUniverse::update_chunk_stats(Chunk *chunk, const uint8_t *c) {
+    chunk->population = 0;
+    chunk->extent = empty_extent();
+    for (int r = 0; r < CHUNK_SIZE; r++) {
+        const uint8_t *row = c + r * CHUNK_SIZE;
+        uint64_t row_sum = 0;
+        long row_population = 0;
+        for (int j = 0; j < CHUNK_SIZE; j++) {
+            row_sum += cell_term(chunk->col_keys[j], row[j]);
+            row_population += row[j];
+        }
+        chunk->row_sums[r] = row_sum;
+        if (row_population == 0)
+            continue;
+        chunk->population += row_population;
+        const int64_t global_row = chunk->ci * CHUNK_SIZE + r;
+        const int64_t c0 = chunk->cj * CHUNK_SIZE;
+        int first = 0, last = CHUNK_SIZE - 1;
+        while (row[first] == 0)
+            first++;
+        while (row[last] == 0)
+            last--;
+        Extent &e = chunk->extent;
+        e.min_row = std::min(e.min_row, global_row);
+        e.max_row = std::max(e.max_row, global_row);
+        e.min_col = std::min(e.min_col, c0 + first);
+        e.max_col = std::max(e.max_col, c0 + last);
+    }
+}
+
+void ChunkedUniverse::shrink() {
+    std::vector<Chunk *> kept;
+    kept.reserve(chunk_list.size());
+    for (Chunk *chunk : chunk_list) {
+        chunk->empty_generations =
+            (chunk->population == 0) ? chunk->empty_generations + 1 : 0;
+        if (chunk->empty_generations > CHUNK_FREE_AFTER) {
+            chunks.erase(chunk_key(chunk->ci, chunk->cj));
+            delete chunk;
+        } else {
+            kept.push_back(chunk);
+        }
+    }
+    chunk_list.swap(kept);
+}
+
+void ChunkedUniverse::update_stats() {
+    population = 0;
+    extent = empty_extent();
+    // A grid row is spread over several chunks, so the row sums are added
+    // up per grid row before they are mixed.
+    std::vector<std::pair<int64_t, uint64_t>> row_sums;
+    for (const Chunk *chunk : chunk_list) {
+        if (chunk->population == 0)
+            continue;
+        population += chunk->population;
+        extent.min_row = std::min(extent.min_row, chunk->extent.min_row);
+        extent.min_col = std::min(extent.min_col, chunk->extent.min_col);
+        extent.max_row = std::max(extent.max_row, chunk->extent.max_row);
+        extent.max_col = std::max(extent.max_col, chunk->extent.max_col);
+        for (int r = 0; r < CHUNK_SIZE; r++) {
+            if (chunk->row_sums[r] != 0)
+                row_sums.push_back({chunk->ci * CHUNK_SIZE + r,
+                                    chunk->row_sums[r]});
+        }
+    }
+    std::sort(row_sums.begin(), row_sums.end());
+    hash = 0;
+    size_t k = 0;
+    while (k < row_sums.size()) {
+        int64_t row = row_sums[k].first;
+        uint64_t sum = 0;
+        for (; k < row_sums.size() && row_sums[k].first == row; k++) {
+            sum += row_sums[k].second;
+        }
+        hash ^= row_hash(row, sum);
+    }
+}
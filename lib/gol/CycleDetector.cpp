@@ -0,0 +1,72 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#include "gol/CycleDetector.h"
+
+CycleDetector::CycleDetector(int capacity) : ring(capacity < 2 ? 2 : capacity) {
+    reset();
+}
+
+void CycleDetector::reset() {
+    count = 0;
+    period = 0;
+    confirmed_at = -1;
+    cycle_start = -1;
+}
+
+void CycleDetector::push(uint64_t hash) {
+    ring[count % ring.size()] = hash;
+    count++;
+    // Once confirmed, a deterministic system stays in its cycle.
+    if (period > 0)
+        return;
+    const int max_period = (int)ring.size() / 2;
+    for (int p = 1; p <= max_period; p++) {
+        if (is_cycle(p)) {
+            period = p;
+            confirmed_at = count - 1;
+            // Walk back as far as the history allows to find where the
+            // grid entered the cycle.
+            const long oldest = count - (long)ring.size();
+            cycle_start = confirmed_at - 2 * p + 1;
+            while (cycle_start - 1 >= 0 && cycle_start - 1 >= oldest &&
+                   at(cycle_start - 1) == at(cycle_start - 1 + p)) {
+                cycle_start--;
+            }
+            return;
+        }
+    }
+}
+
+int CycleDetector::get_period() const { return period; }
+
+long CycleDetector::get_confirmed_at() const { return confirmed_at; }
+
+long CycleDetector::get_cycle_start() const { return cycle_start; }
+
+uint64_t CycleDetector::at(long generation) const {
+    return ring[generation % ring.size()];
+}
+
+bool CycleDetector::is_cycle(int p) const {
+    // Need two full periods in the history.
+    if (count < 2 * (long)p)
+        return false;
+    const long last = count - 1;
+    for (long k = 0; k < p; k++) {
+        if (at(last - k) != at(last - k - p))
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,168 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#include "gol/DensityPyramid.h"
+#include <algorithm>
+
+// Sums the 2x2 blocks [c0, c1) of two source rows into out; row1 is nullptr
+// at an odd last row, and an odd last column is summed alone.
+template <typename T>
+static void sum_blocks(const T *row0, const T *row1, int src_cols,
+                       uint32_t *out, int c0, int c1) {
+    const int pairs = std::min(c1, src_cols / 2);
+    if (row1 != nullptr) {
+        for (int c = c0; c < pairs; c++)
+            out[c] = row0[2 * c] + row0[2 * c + 1] + row1[2 * c] +
+                     row1[2 * c + 1];
+    } else {
+        for (int c = c0; c < pairs; c++)
+            out[c] = row0[2 * c] + row0[2 * c + 1];
+    }
+    if (c1 > pairs) {
+        const int c = pairs;
+        out[c] = row0[2 * c] + (row1 != nullptr ? row1[2 * c] : 0);
+    }
+}
+
+DensityPyramid::DensityPyramid(int rows_, int cols_)
+    : rows(rows_), cols(cols_), levels(0) {
+    int r = rows;
+    int c = cols;
+    while ((r > 1 || c > 1) && levels < PYRAMID_MAX_LEVEL) {
+        r = (r + 1) / 2;
+        c = (c + 1) / 2;
+        levels++;
+        level_rows.push_back(r);
+        level_cols.push_back(c);
+        counts.emplace_back((size_t)r * c, 0);
+    }
+    mark(0, 0, rows, cols);
+}
+
+DensityPyramid::~DensityPyramid() {}
+
+void DensityPyramid::mark(int min_row, int min_col, int max_row,
+                          int max_col) {
+    min_row = std::max(min_row, 0);
+    min_col = std::max(min_col, 0);
+    max_row = std::min(max_row, rows);
+    max_col = std::min(max_col, cols);
+    if (min_row < max_row && min_col < max_col)
+        marked.emplace_back(min_row, min_col, max_row, max_col);
+}
+
+void DensityPyramid::update(int **xt) {
+    // Every marked rectangle is halved from level to level, and the blocks
+    // under it are summed from the level below. Rectangles that share a
+    // block at a coarse level sum it more than once, which costs at most
+    // one block per rectangle and level.
+    int src_rows = rows;
+    int src_cols = cols;
+    for (int l = 0; l < levels; l++) {
+        for (auto &rect : marked) {
+            const int r0 = std::get<0>(rect) / 2;
+            const int c0 = std::get<1>(rect) / 2;
+            const int r1 = (std::get<2>(rect) + 1) / 2;
+            const int c1 = (std::get<3>(rect) + 1) / 2;
+            for (int r = r0; r < r1; r++) {
+                uint32_t *out = &counts[l][(size_t)r * level_cols[l]];
+                const bool pair = 2 * r + 1 < src_rows;
+                if (l == 0) {
+                    sum_blocks<int>(xt[2 * r], pair ? xt[2 * r + 1] : nullptr,
+                                    src_cols, out, c0, c1);
+                } else {
+                    const uint32_t *src = counts[l - 1].data();
+                    sum_blocks<uint32_t>(
+                        src + (size_t)2 * r * src_cols,
+                        pair ? src + (size_t)(2 * r + 1) * src_cols : nullptr,
+                        src_cols, out, c0, c1);
+                }
+            }
+            rect = std::make_tuple(r0, c0, r1, c1);
+        }
+        src_rows = level_rows[l];
+        src_cols = level_cols[l];
+    }
+    marked.clear();
+}
+
+int DensityPyramid::get_levels() const { return levels; }
+
+int DensityPyramid::get_level_rows(int level) const {
+    return level_rows[level - 1];
+}
+
+int DensityPyramid::get_level_cols(int level) const {
+    return level_cols[level - 1];
+}
+
+uint32_t DensityPyramid::get_count(int level, int row, int col) const {
+    return counts[level - 1][(size_t)row * level_cols[level - 1] + col];
+}
+
+// Blocks of one axis that are counted in each of n output pixels: those
+// that start in the cells of the pixel, or else the block the pixel starts
+// in. Also sums the cells of these blocks per pixel.
+static void pixel_blocks(int cells, int n, int block, int n_blocks,
+                         std::vector<int> &first, std::vector<int> &last,
+                         std::vector<long> &span) {
+    first.resize(n);
+    last.resize(n);
+    span.resize(n);
+    for (int k = 0; k < n; k++) {
+        const long c0 = (long)k * cells / n;
+        const long c1 = (long)(k + 1) * cells / n;
+        int b0 = (int)((c0 + block - 1) / block);
+        int b1 = std::min(n_blocks, (int)((c1 + block - 1) / block));
+        if (b0 >= b1) {
+            // A domain less than twice the output.
+            b0 = (int)(c0 / block);
+            b1 = b0 + 1;
+        }
+        first[k] = b0;
+        last[k] = b1;
+        span[k] = std::min((long)b1 * block, (long)cells) - (long)b0 * block;
+    }
+}
+
+void DensityPyramid::sample(int out_rows, int out_cols, float *density) const {
+    if (levels == 0 || out_rows <= 0 || out_cols <= 0)
+        return;
+    // The pixel rectangles are at least 2^level cells on each side, so
+    // every block starts in exactly one pixel and is counted there.
+    const int min_span = std::min(rows / out_rows, cols / out_cols);
+    int level = 1;
+    while (level < levels && (2 << level) <= min_span)
+        level++;
+    const int block = 1 << level;
+    const int n_cols = level_cols[level - 1];
+    const uint32_t *count = counts[level - 1].data();
+    std::vector<int> row_first, row_last, col_first, col_last;
+    std::vector<long> height, width;
+    pixel_blocks(rows, out_rows, block, level_rows[level - 1], row_first,
+                 row_last, height);
+    pixel_blocks(cols, out_cols, block, n_cols, col_first, col_last, width);
+    for (int y = 0; y < out_rows; y++) {
+        for (int x = 0; x < out_cols; x++) {
+            uint64_t live = 0;
+            for (int br = row_first[y]; br < row_last[y]; br++) {
+                const uint32_t *row = count + (size_t)br * n_cols;
+                for (int bc = col_first[x]; bc < col_last[x]; bc++)
+                    live += row[bc];
+            }
+            density[(size_t)y * out_cols + x] =
+                (float)live / ((double)height[y] * width[x]);
+        }
+    }
+}
@@ -0,0 +1,356 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#include "gol/FrameExporter.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#if defined(_WIN32)
+#define popen _popen
+#define pclose _pclose
+#endif
+
+// Colors of the GUI: black cells on a white background.
+#define EXPORT_COLOR_ALIVE 0
+#define EXPORT_COLOR_DEAD 255
+
+//------------------------------------------------------------------------------
+// Minimal PNG encoder: 1 bit grayscale, "up" filter and a single deflate
+// block with fixed Huffman codes and run-length matches. Zoomed frames are
+// mostly repeated rows, which the filter turns into long runs of zeros.
+//------------------------------------------------------------------------------
+
+namespace {
+
+class BitWriter {
+  public:
+    BitWriter(std::vector<uint8_t> &out_) : out(out_), buffer(0), n_bits(0) {}
+
+    void put(uint32_t bits, int n) {
+        buffer |= bits << n_bits;
+        n_bits += n;
+        while (n_bits >= 8) {
+            out.push_back(buffer & 0xff);
+            buffer >>= 8;
+            n_bits -= 8;
+        }
+    }
+
+    // Huffman codes are stored most significant bit first.
+    void put_code(uint32_t code, int length) {
+        uint32_t reversed = 0;
+        for (int i = 0; i < length; i++) {
+            reversed = (reversed << 1) | ((code >> i) & 1);
+        }
+        put(reversed, length);
+    }
+
+    void flush() {
+        if (n_bits > 0)
+            out.push_back(buffer & 0xff);
+        buffer = 0;
+        n_bits = 0;
+    }
+
+  private:
+    std::vector<uint8_t> &out;
+    uint32_t buffer;
+    int n_bits;
+};
+
+void put_symbol(BitWriter &bits, int symbol) {
+    if (symbol < 144)
+        bits.put_code(0x30 + symbol, 8);
+    else if (symbol < 256)
+        bits.put_code(0x190 + symbol - 144, 9);
+    else if (symbol < 280)
+        bits.put_code(symbol - 256, 7);
+    else
+        bits.put_code(0xc0 + symbol - 280, 8);
+}
+
+void put_length(BitWriter &bits, int length) {
+    static const int base[] = {3,  4,  5,  6,  7,  8,  9,  10,  11,  13,
+                               15, 17, 19, 23, 27, 31, 35, 43,  51,  59,
+                               67, 83, 99, 115, 131, 163, 195, 227, 258};
+    static const int extra[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    int code = 28;
+    while (base[code] > length)
+        code--;
+    put_symbol(bits, 257 + code);
+    bits.put(length - base[code], extra[code]);
+    // Distance 1: code 0, no extra bits.
+    bits.put_code(0, 5);
+}
+
+std::vector<uint8_t> zlib_compress(const std::vector<uint8_t> &data) {
+    std::vector<uint8_t> out = {0x78, 0x01};
+    BitWriter bits(out);
+    // Final block, fixed Huffman codes.
+    bits.put(1, 1);
+    bits.put(1, 2);
+    size_t p = 0;
+    while (p < data.size()) {
+        put_symbol(bits, data[p]);
+        size_t run = 0;
+        while (p + 1 + run < data.size() && run < 258 &&
+               data[p + 1 + run] == data[p]) {
+            run++;
+        }
+        if (run >= 3) {
+            put_length(bits, run);
+            p += run;
+        }
+        p++;
+    }
+    put_symbol(bits, 256);
+    bits.flush();
+    uint32_t a = 1, b = 0;
+    for (uint8_t byte : data) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    uint32_t adler = (b << 16) | a;
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out.push_back((adler >> shift) & 0xff);
+    }
+    return out;
+}
+
+uint32_t crc32(const uint8_t *data, size_t n, uint32_t crc = 0) {
+    static uint32_t table[256];
+    static bool initialized = false;
+    if (!initialized) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xedb88320 ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        initialized = true;
+    }
+    crc = ~crc;
+    for (size_t i = 0; i < n; i++) {
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+void put_u32(std::vector<uint8_t> &out, uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out.push_back((value >> shift) & 0xff);
+    }
+}
+
+void put_chunk(std::vector<uint8_t> &out, const char *type,
+               const std::vector<uint8_t> &data) {
+    put_u32(out, data.size());
+    size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    put_u32(out, crc32(out.data() + start, out.size() - start));
+}
+
+} // namespace
+
+// The CRC table is built on first use; build it before the workers start.
+static const uint32_t crc32_warmup = crc32(nullptr, 0);
+
+FrameExporter::FrameExporter(Config config_, int format_,
+                             const std::string &output_)
+    : config(config_), format(format_), output(output_), pipe(nullptr),
+      stopping(false), n_frames(0), next_to_write(0) {
+    if (config.zoom_factor < 1)
+        config.zoom_factor = 1;
+    frame_w = config.cols * config.zoom_factor;
+    frame_h = config.rows * config.zoom_factor;
+    if (format == EXPORT_RAW) {
+        pipe = popen(output.c_str(), "w");
+        if (pipe == nullptr) {
+            std::cout << "--- Could not start encoder: " << output
+                      << std::endl;
+        }
+    } else {
+        std::filesystem::create_directories(output);
+    }
+    int n_workers = std::thread::hardware_concurrency();
+    if (n_workers < 1)
+        n_workers = 1;
+    max_queue = 2 * n_workers;
+    std::cout << "--- Exporting " << frame_w << "x" << frame_h
+              << " frames using " << n_workers << " threads." << std::endl;
+    for (int i = 0; i < n_workers; i++) {
+        workers.push_back(std::thread(&FrameExporter::work, this));
+    }
+}
+
+FrameExporter::~FrameExporter() { finish(); }
+
+void FrameExporter::push(int **xt, long generation) {
+    ExportJob job;
+    job.generation = generation;
+    job.cells.resize((size_t)config.rows * config.cols);
+    for (int i = 0; i < config.rows; i++) {
+        uint8_t *row = job.cells.data() + (size_t)i * config.cols;
+        for (int j = 0; j < config.cols; j++) {
+            row[j] = xt[i][j];
+        }
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    queue_changed.wait(lock, [this] { return queue.size() < max_queue; });
+    job.index = n_frames++;
+    queue.push_back(std::move(job));
+    queue_changed.notify_all();
+}
+
+void FrameExporter::finish() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping)
+            return;
+        stopping = true;
+    }
+    queue_changed.notify_all();
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+    if (pipe != nullptr) {
+        pclose(pipe);
+        pipe = nullptr;
+    }
+}
+
+long FrameExporter::get_n_frames() const { return n_frames; }
+
+int FrameExporter::get_frame_w() const { return frame_w; }
+
+int FrameExporter::get_frame_h() const { return frame_h; }
+
+void FrameExporter::work() {
+    while (true) {
+        ExportJob job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            queue_changed.wait(lock,
+                               [this] { return !queue.empty() || stopping; });
+            if (queue.empty())
+                return;
+            job = std::move(queue.front());
+            queue.pop_front();
+            queue_changed.notify_all();
+        }
+        switch (format) {
+        case EXPORT_PNG:
+            write_png(job);
+            break;
+        case EXPORT_RAW:
+            write_raw(job);
+            break;
+        default:
+            write_ppm(job);
+        }
+    }
+}
+
+void FrameExporter::render_rgb(const ExportJob &job,
+                               std::vector<uint8_t> &rgb) const {
+    const int zoom = config.zoom_factor;
+    rgb.resize((size_t)frame_w * frame_h * 3);
+    for (int i = 0; i < config.rows; i++) {
+        uint8_t *line = rgb.data() + (size_t)i * zoom * frame_w * 3;
+        const uint8_t *cells = job.cells.data() + (size_t)i * config.cols;
+        for (int j = 0; j < config.cols; j++) {
+            uint8_t color = cells[j] ? EXPORT_COLOR_ALIVE : EXPORT_COLOR_DEAD;
+            std::fill(line + (size_t)j * zoom * 3,
+                      line + (size_t)(j + 1) * zoom * 3, color);
+        }
+        // Repeat the line for the zoomed rows.
+        for (int z = 1; z < zoom; z++) {
+            std::copy(line, line + (size_t)frame_w * 3,
+                      line + (size_t)z * frame_w * 3);
+        }
+    }
+}
+
+void FrameExporter::write_ppm(const ExportJob &job) const {
+    std::vector<uint8_t> rgb;
+    render_rgb(job, rgb);
+    std::ofstream file(frame_filename(job, "ppm"), std::ios::binary);
+    file << "P6\n" << frame_w << " " << frame_h << "\n255\n";
+    file.write((const char *)rgb.data(), rgb.size());
+}
+
+void FrameExporter::write_png(const ExportJob &job) const {
+    const int zoom = config.zoom_factor;
+    const size_t stride = (frame_w + 7) / 8;
+    // One filter byte plus the packed pixels per row, white is 1.
+    std::vector<uint8_t> line(stride);
+    std::vector<uint8_t> previous(stride, 0);
+    std::vector<uint8_t> filtered;
+    filtered.reserve((stride + 1) * frame_h);
+    for (int y = 0; y < frame_h; y++) {
+        const uint8_t *cells =
+            job.cells.data() + (size_t)(y / zoom) * config.cols;
+        std::fill(line.begin(), line.end(), 0xff);
+        for (int x = 0; x < frame_w; x++) {
+            if (cells[x / zoom])
+                line[x >> 3] &= ~(0x80 >> (x & 7));
+        }
+        filtered.push_back(2);
+        for (size_t k = 0; k < stride; k++) {
+            filtered.push_back((uint8_t)(line[k] - previous[k]));
+        }
+        line.swap(previous);
+    }
+    std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    std::vector<uint8_t> header;
+    put_u32(header, frame_w);
+    put_u32(header, frame_h);
+    // Bit depth 1, grayscale, deflate, adaptive filtering, no interlace.
+    header.insert(header.end(), {1, 0, 0, 0, 0});
+    put_chunk(png, "IHDR", header);
+    put_chunk(png, "IDAT", zlib_compress(filtered));
+    put_chunk(png, "IEND", {});
+    std::ofstream file(frame_filename(job, "png"), std::ios::binary);
+    file.write((const char *)png.data(), png.size());
+}
+
+void FrameExporter::write_raw(const ExportJob &job) {
+    std::vector<uint8_t> rgb;
+    render_rgb(job, rgb);
+    std::lock_guard<std::mutex> lock(pipe_mutex);
+    pending[job.index] = std::move(rgb);
+    // Write all frames that are next in line.
+    auto it = pending.find(next_to_write);
+    while (it != pending.end()) {
+        if (pipe != nullptr)
+            fwrite(it->second.data(), 1, it->second.size(), pipe);
+        pending.erase(it);
+        it = pending.find(++next_to_write);
+    }
+}
+
+std::string FrameExporter::frame_filename(const ExportJob &job,
+                                          const std::string &extension) const {
+    std::stringstream ss;
+    ss << output << "/frame_" << std::setw(6) << std::setfill('0')
+       << job.generation << "." << extension;
+    return ss.str();
+}
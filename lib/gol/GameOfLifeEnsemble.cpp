@@ -0,0 +1,216 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#include "gol/GameOfLifeEnsemble.h"
+#include "gol/CellHash.h"
+#include "gol/GameOfLifeKernel.h"
+#include "gol/Profiler.h"
+#include "gol/Rules.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+// Universes are handed out to the threads in multiples of this, so every
+// thread runs full SIMD lanes.
+#define ENSEMBLE_LANE_BLOCK 32
+
+GameOfLifeEnsemble::GameOfLifeEnsemble(Config config_, int n_universes_,
+                                       unsigned int seed_)
+    : config(config_), n_universes(n_universes_), seed(seed_),
+      padded_cols(config_.cols + 2), generation(0) {
+    // Setup concurrency
+    int n_cpus = std::thread::hardware_concurrency();
+    int n_blocks =
+        (n_universes + ENSEMBLE_LANE_BLOCK - 1) / ENSEMBLE_LANE_BLOCK;
+    if (config.with_threads) {
+        batch_ranges(n_universes, std::min(n_cpus, n_blocks));
+    } else {
+        batch_ranges(n_universes, 1);
+    }
+    threads = new std::thread[batches.size()];
+    std::cout << "--- Ensemble of " << n_universes << " universes of "
+              << config.cols << "x" << config.rows << ", using "
+              << batches.size() << " threads." << std::endl;
+    // Alloc - init domains, including the halo.
+    const size_t n_cells = (size_t)(config.rows + 2) * padded_cols;
+    xt0.assign(n_cells * n_universes, 0);
+    xt1.assign(n_cells * n_universes, 0);
+    hashes.assign(n_universes, 0);
+    populations.assign(n_universes, 0);
+    cycle_detectors.resize(n_universes);
+    set_initial_conditions();
+}
+
+GameOfLifeEnsemble::~GameOfLifeEnsemble() { delete[] threads; }
+
+void GameOfLifeEnsemble::timestep() {
+    GOL_PROFILE_SCOPE("timestep");
+    if (batches.size() == 1) {
+        timestep_universes(std::get<0>(batches[0]), std::get<1>(batches[0]));
+    } else {
+        for (size_t t = 0; t < batches.size(); t++) {
+            threads[t] = std::thread(&GameOfLifeEnsemble::timestep_universes,
+                                     this, std::get<0>(batches[t]),
+                                     std::get<1>(batches[t]));
+        }
+        for (size_t t = 0; t < batches.size(); t++) {
+            threads[t].join();
+        }
+    }
+    xt0.swap(xt1);
+    generation++;
+}
+
+void GameOfLifeEnsemble::run(int n_steps) {
+    for (int step = 0; step < n_steps; step++) {
+        if (all_settled())
+            break;
+        timestep();
+    }
+}
+
+bool GameOfLifeEnsemble::all_settled() const {
+    for (const CycleDetector &detector : cycle_detectors) {
+        if (detector.get_period() == 0)
+            return false;
+    }
+    return true;
+}
+
+int GameOfLifeEnsemble::get_n_universes() const { return n_universes; }
+
+int GameOfLifeEnsemble::get_n_threads() const { return batches.size(); }
+
+long GameOfLifeEnsemble::get_generation() const { return generation; }
+
+UniverseStats GameOfLifeEnsemble::get_stats(int universe) const {
+    const CycleDetector &detector = cycle_detectors.at(universe);
+    UniverseStats stats;
+    stats.seed = seed + universe;
+    stats.population = populations.at(universe);
+    stats.period = detector.get_period();
+    stats.stabilized_at = detector.get_cycle_start();
+    return stats;
+}
+
+int GameOfLifeEnsemble::get_xt_at(int universe, int row, int col) const {
+    return xt0[index(row, col) + universe];
+}
+
+size_t GameOfLifeEnsemble::index(int row, int col) const {
+    return ((size_t)(row + 1) * padded_cols + (col + 1)) * n_universes;
+}
+
+void GameOfLifeEnsemble::set_initial_conditions() {
+    for (int u = 0; u < n_universes; u++) {
+        std::mt19937 gen(seed + u);
+        std::bernoulli_distribution distribution(config.density);
+        uint64_t hash = 0;
+        long population = 0;
+        for (int i = 0; i < config.rows; i++) {
+            uint64_t row_sum = 0;
+            for (int j = 0; j < config.cols; j++) {
+                uint8_t value = distribution(gen);
+                xt0[index(i, j) + u] = value;
+                row_sum += cell_term(column_key(j), value);
+                population += value;
+            }
+            hash ^= row_hash(i, row_sum);
+        }
+        hashes[u] = hash;
+        populations[u] = population;
+        cycle_detectors[u].push(hash);
+    }
+}
+
+void GameOfLifeEnsemble::apply_boundary_conditions(const int min_u,
+                                                   const int max_u) {
+    // With constant boundaries the halo is zero and never written.
+    if (config.boundary_type == BOUNDARY_CONSTANT)
+        return;
+    const bool periodic = config.boundary_type != BOUNDARY_MIRROR;
+    const size_t n_bytes = max_u - min_u;
+    uint8_t *x = xt0.data() + min_u;
+    const int rows = config.rows;
+    const int cols = config.cols;
+    // Halo rows first, then the halo columns including the corners.
+    const int top = periodic ? rows - 1 : 1;
+    const int bottom = periodic ? 0 : rows - 2;
+    for (int j = 0; j < cols; j++) {
+        std::memcpy(x + index(-1, j), x + index(top, j), n_bytes);
+        std::memcpy(x + index(rows, j), x + index(bottom, j), n_bytes);
+    }
+    const int left = periodic ? cols - 1 : 1;
+    const int right = periodic ? 0 : cols - 2;
+    for (int i = -1; i <= rows; i++) {
+        std::memcpy(x + index(i, -1), x + index(i, left), n_bytes);
+        std::memcpy(x + index(i, cols), x + index(i, right), n_bytes);
+    }
+}
+
+void GameOfLifeEnsemble::timestep_universes(const int min_u, const int max_u) {
+    GOL_PROFILE_WORKER("worker", min_u / ENSEMBLE_LANE_BLOCK);
+    apply_boundary_conditions(min_u, max_u);
+    const int n = max_u - min_u;
+    const ptrdiff_t lane = n_universes;
+    const ptrdiff_t row_stride = (ptrdiff_t)padded_cols * n_universes;
+    std::vector<uint64_t> hash(n, 0);
+    std::vector<uint64_t> row_sum(n, 0);
+    std::vector<uint32_t> population(n, 0);
+    uint64_t *s = row_sum.data();
+    uint32_t *p = population.data();
+    for (int i = 0; i < config.rows; i++) {
+        std::fill(row_sum.begin(), row_sum.end(), 0);
+        for (int j = 0; j < config.cols; j++) {
+            const uint8_t *c = xt0.data() + index(i, j) + min_u;
+            const uint8_t *up = c - row_stride;
+            const uint8_t *down = c + row_stride;
+            uint8_t *out = xt1.data() + index(i, j) + min_u;
+            // Keep the step in 8 bit lanes, so it vectorizes well.
+            for (int u = 0; u < n; u++) {
+                uint8_t sum = up[u - lane] + up[u] + up[u + lane] +
+                              c[u - lane] + c[u + lane] + down[u - lane] +
+                              down[u] + down[u + lane];
+                out[u] = ConwayRule::next(c[u], sum);
+            }
+            const uint64_t key = column_key(j);
+            for (int u = 0; u < n; u++) {
+                s[u] += key & (0 - (uint64_t)out[u]);
+                p[u] += out[u];
+            }
+        }
+        for (int u = 0; u < n; u++) {
+            hash[u] ^= row_hash(i, s[u]);
+        }
+    }
+    for (int u = 0; u < n; u++) {
+        hashes[min_u + u] = hash[u];
+        populations[min_u + u] = population[u];
+        cycle_detectors[min_u + u].push(hash[u]);
+    }
+}
+
+void GameOfLifeEnsemble::batch_ranges(int n_samples, int n_batches) {
+    if (n_batches < 1)
+        n_batches = 1;
+    int n_blocks = (n_samples + ENSEMBLE_LANE_BLOCK - 1) / ENSEMBLE_LANE_BLOCK;
+    int blocks_per_batch = (n_blocks + n_batches - 1) / n_batches;
+    int batch_size = blocks_per_batch * ENSEMBLE_LANE_BLOCK;
+    for (int start = 0; start < n_samples; start += batch_size) {
+        batches.push_back(
+            std::tuple<int, int>{start, std::min(start + batch_size, n_samples)});
+    }
+}
@@ -13,101 +13,550 @@
 //   limitations under the License.
 //
 #include "gol/GameOfLifeKernel.h"
+#include "gol/CellHash.h"
+#include "gol/Kernels.h"
+#include "gol/Profiler.h"
+#include "gol/Rules.h"
+#include <algorithm>
 #include <assert.h>
 #include <cmath>
 #include <ctime>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <random>
 #include <sstream>
 
-GameOfLifeKernel::GameOfLifeKernel(Config config_) : config(config_) {
+GameOfLifeKernel::GameOfLifeKernel(Config config_, GridArena *arena_)
+    : config(config_), arena(arena_), owns_arena(arena_ == nullptr),
+      generation(0), row_sums(config_.rows, 0),
+      row_populations(config_.rows, 0), hash(0), population(0),
+      universe(nullptr), sparse(nullptr), sparse_active(false),
+      dense_stale(false), edit_log(nullptr), pyramid(nullptr) {
     // Setup concurrency
     n_cpus = std::thread::hardware_concurrency();
     if (config.with_threads) {
-        batch_ranges(config.rows, n_cpus);
+        batch_ranges(config.rows,
+                     config.n_threads > 0 ? config.n_threads : n_cpus);
     } else {
         batch_ranges(config.rows, 1);
     }
     threads = new std::thread[batches.size()];
     // Print info on the console.
-    std::cout << "--- Availabe CPU cores: " << n_cpus << ", using "
-              << batches.size() << " threads." << std::endl;
-    std::cout << "--- Boundary type: " << config.boundary_type << std::endl;
-    for (int t = 0; t < batches.size(); t++) {
-        auto batch = batches.at(t);
-        std::cout << "batch " << std::setw(2) << t << ":    " << std::setw(4)
-                  << std::get<0>(batch) << " - " << std::setw(4)
-                  << std::get<1>(batch) << std::endl;
-    }
-    // Alloc - init domain
+    if (!config.quiet) {
+        std::cout << "--- Availabe CPU cores: " << n_cpus << ", using "
+                  << batches.size() << " threads." << std::endl;
+        std::cout << "--- Boundary type: " << config.boundary_type
+                  << std::endl;
+        for (int t = 0; t < batches.size(); t++) {
+            auto batch = batches.at(t);
+            std::cout << "batch " << std::setw(2) << t << ":    "
+                      << std::setw(4) << std::get<0>(batch) << " - "
+                      << std::setw(4) << std::get<1>(batch) << std::endl;
+        }
+    }
+    // Alloc - init domain. Each buffer is one contiguous block, so it can
+    // be handed out with a stride. Both come from one arena. On huge pages
+    // the buffers are physically contiguous, and if they were a power of
+    // two apart, row i of both would map to the same cache sets; the second
+    // is therefore shifted by an odd number of cache lines.
+    if (owns_arena)
+        arena = new GridArena();
+    size_t buffer_bytes =
+        ((size_t)config.rows * config.cols * sizeof(int) + 4095) / 4096 * 4096 +
+        KERNEL_BUFFER_STAGGER;
+    data0 = (int *)arena->acquire(2 * buffer_bytes);
+    data1 = (int *)((char *)data0 + buffer_bytes);
     xt0 = new int *[config.rows];
     xt1 = new int *[config.rows];
     for (int i = 0; i < config.rows; i++) {
-        xt0[i] = new int[config.cols];
-        xt1[i] = new int[config.cols];
+        xt0[i] = data0 + (size_t)i * config.cols;
+        xt1[i] = data1 + (size_t)i * config.cols;
+    }
+    // Freshly mapped pages are zero and need no clearing. xt0 is still
+    // faulted in here by set_initial_conditions(), which draws the whole
+    // grid from one seeded sequence; xt1 is first written while stepping.
+    if (!arena->is_zeroed()) {
+        zeros(xt0);
+        zeros(xt1);
+    }
+    col_keys.resize(config.cols);
+    for (int j = 0; j < config.cols; j++) {
+        col_keys[j] = column_key(j);
+    }
+    tile_h = config.tile_h > 0 ? config.tile_h : KERNEL_TILE_SIZE;
+    tile_w = config.tile_w > 0 ? config.tile_w : KERNEL_TILE_SIZE;
+    tile_rows = (config.rows + tile_h - 1) / tile_h;
+    tile_cols = (config.cols + tile_w - 1) / tile_w;
+    tile_changed.assign(tile_rows * tile_cols, 1);
+    tile_active.assign(tile_rows * tile_cols, 1);
+    segment_changed.assign((size_t)config.rows * tile_cols, 0);
+    segment_sums.assign((size_t)config.rows * tile_cols, 0);
+    segment_populations.assign((size_t)config.rows * tile_cols, 0);
+    if (config.density_pyramid) {
+        pyramid = new DensityPyramid(config.rows, config.cols);
+        pyramid_tiles.assign(tile_rows * tile_cols, 1);
     }
-    zeros(xt0);
-    zeros(xt1);
     set_initial_conditions();
+    if (config.boundary_type == BOUNDARY_UNBOUNDED) {
+        // The domain becomes a viewport on an unbounded universe.
+        universe = new ChunkedUniverse(batches.size());
+        universe->copy_from(xt0, 0, 0, config.rows, config.cols);
+    }
+    if (config.sparse_density > 0 &&
+        (config.boundary_type == BOUNDARY_CONSTANT ||
+         config.boundary_type == BOUNDARY_PERIODIC)) {
+        sparse = new SparseUniverse(config.rows, config.cols,
+                                    config.boundary_type);
+    }
+    cycle_detector.push(hash);
+
+    select_kernel();
+}
 
-    // Set boundary condition function
+GameOfLifeKernel::~GameOfLifeKernel() {
+    delete universe;
+    delete sparse;
+    delete pyramid;
+    if (owns_arena)
+        delete arena;
+    delete[] xt0;
+    delete[] xt1;
+    delete[] threads;
+}
+
+void GameOfLifeKernel::select_kernel() {
+    if (config.kernel_variant == KERNEL_GENERIC) {
+        fpr_timestep_subdomain = &GameOfLifeKernel::timestep_subdomain;
+        switch (config.boundary_type) {
+        case BOUNDARY_CONSTANT:
+            fpr_apply_boundary_conditions =
+                &GameOfLifeKernel::apply_constant_boundary_conditions;
+            break;
+        case BOUNDARY_PERIODIC:
+            fpr_apply_boundary_conditions =
+                &GameOfLifeKernel::apply_periodic_boundary_conditions;
+            break;
+        case BOUNDARY_MIRROR:
+            fpr_apply_boundary_conditions =
+                &GameOfLifeKernel::apply_mirror_boundary_conditions;
+            break;
+        default:
+            fpr_apply_boundary_conditions =
+                &GameOfLifeKernel::apply_periodic_boundary_conditions;
+        }
+        return;
+    }
+    // The specialized kernels are resolved once here, so a time step makes
+    // one indirect call per phase instead of one per cell.
+    fpr_timestep_subdomain = &GameOfLifeKernel::timestep_subdomain_specialized;
     switch (config.boundary_type) {
     case BOUNDARY_CONSTANT:
         fpr_apply_boundary_conditions =
-            &GameOfLifeKernel::apply_constant_boundary_conditions;
-        break;
-    case BOUNDARY_PERIODIC:
-        fpr_apply_boundary_conditions =
-            &GameOfLifeKernel::apply_periodic_boundary_conditions;
+            &GameOfLifeKernel::apply_specialized_boundary_conditions<
+                BOUNDARY_CONSTANT>;
         break;
     case BOUNDARY_MIRROR:
         fpr_apply_boundary_conditions =
-            &GameOfLifeKernel::apply_mirror_boundary_conditions;
+            &GameOfLifeKernel::apply_specialized_boundary_conditions<
+                BOUNDARY_MIRROR>;
         break;
     default:
         fpr_apply_boundary_conditions =
-            &GameOfLifeKernel::apply_periodic_boundary_conditions;
+            &GameOfLifeKernel::apply_specialized_boundary_conditions<
+                BOUNDARY_PERIODIC>;
     }
 }
 
-GameOfLifeKernel::~GameOfLifeKernel() {
-    for (int i = 0; i < config.rows; i++) {
-        delete[] xt0[i];
-        delete[] xt1[i];
-    }
-    delete[] xt0;
-    delete[] xt1;
-    delete[] threads;
-}
-
 void GameOfLifeKernel::timestep() {
+    GOL_PROFILE_SCOPE("timestep");
+    apply_edits();
+    if (universe != nullptr) {
+        timestep_unbounded();
+        return;
+    }
+    select_engine();
+    if (sparse_active) {
+        timestep_sparse();
+        return;
+    }
+    if (config.kernel_variant == KERNEL_SPECIALIZED)
+        update_active_tiles();
     // compute inner domain
-    if (config.with_threads) {
-        start_threads(&GameOfLifeKernel::timestep_subdomain, this);
-    } else {
-        start_no_threads(&GameOfLifeKernel::timestep_subdomain, this);
+    {
+        GOL_PROFILE_SCOPE("interior");
+        if (config.with_threads) {
+            start_threads(fpr_timestep_subdomain, this);
+        } else {
+            start_no_threads(fpr_timestep_subdomain, this);
+        }
     }
     // compute boundaries
-    (this->*fpr_apply_boundary_conditions)();
+    {
+        GOL_PROFILE_SCOPE("boundary");
+        (this->*fpr_apply_boundary_conditions)();
+    }
+    if (config.kernel_variant == KERNEL_SPECIALIZED)
+        update_changed_tiles();
+    {
+        GOL_PROFILE_SCOPE("hash");
+        hash_boundary();
+        update_hash();
+    }
     // swap buffers
     int **tmp = xt0;
     xt0 = xt1;
     xt1 = tmp;
-    zeros(xt1);
+    if (config.kernel_variant != KERNEL_SPECIALIZED) {
+        GOL_PROFILE_SCOPE("zeros");
+        zeros(xt1);
+    }
+    update_pyramid_tiles();
+    generation++;
+    cycle_detector.push(hash);
+}
+
+void GameOfLifeKernel::timestep_unbounded() {
+    universe->timestep();
+    {
+        GOL_PROFILE_SCOPE("viewport");
+        universe->copy_to(xt0, 0, 0, config.rows, config.cols);
+    }
+    hash = universe->get_hash();
+    population = universe->get_population();
+    update_pyramid_tiles();
+    generation++;
+    cycle_detector.push(hash);
+}
+
+void GameOfLifeKernel::select_engine() {
+    if (sparse == nullptr)
+        return;
+    // Switch back at twice the density, so a population around the
+    // threshold doesn't switch every generation.
+    double density = (double)population / ((double)config.rows * config.cols);
+    if (!sparse_active && density < config.sparse_density) {
+        sparse->load(xt0);
+        sparse_active = true;
+        dense_stale = false;
+    } else if (sparse_active && density > 2 * config.sparse_density) {
+        sync_dense();
+        sparse_active = false;
+        // xt1 was not kept up to date by the sparse engine.
+        mark_all_tiles_changed();
+    }
+}
+
+void GameOfLifeKernel::timestep_sparse() {
+    // xt0 is either in sync with the sparse cells, or all zeros.
+    if (!dense_stale)
+        sparse->clear_in(xt0);
+    sparse->timestep();
+    dense_stale = true;
+    hash = sparse->get_hash();
+    population = sparse->get_population();
+    update_pyramid_tiles();
+    generation++;
+    cycle_detector.push(hash);
+}
+
+void GameOfLifeKernel::sync_dense() const {
+    if (!dense_stale)
+        return;
+    sparse->set_in(xt0);
+    dense_stale = false;
+}
+
+std::future<long> GameOfLifeKernel::step_async(int n) {
+    return std::async(std::launch::async, [this, n]() {
+        for (int k = 0; k < n; k++) {
+            timestep();
+        }
+        return generation;
+    });
 }
 
 int GameOfLifeKernel::get_n_threads() { return batches.size(); }
 
 int GameOfLifeKernel::get_n_cpus() { return n_cpus; }
 
-int **GameOfLifeKernel::get_xt() const { return xt0; }
+int **GameOfLifeKernel::get_xt() const {
+    sync_dense();
+    return xt0;
+}
+
+const int *GameOfLifeKernel::get_buffer(int *stride) const {
+    sync_dense();
+    *stride = config.cols;
+    return xt0[0];
+}
+
+int GameOfLifeKernel::get_rows() const { return config.rows; }
+
+int GameOfLifeKernel::get_cols() const { return config.cols; }
 
 const int GameOfLifeKernel::get_xt_at(int row, int col) {
+    sync_dense();
     return xt0[row][col];
 }
 
+void GameOfLifeKernel::take_snapshot(GridSnapshot *snapshot) const {
+    sync_dense();
+    snapshot->resize(config.rows, config.cols);
+    std::copy(xt0[0], xt0[0] + (size_t)config.rows * config.cols,
+              snapshot->cells.begin());
+    snapshot->generation = generation;
+    snapshot->population = population;
+    snapshot->hash = hash;
+    snapshot->period = cycle_detector.get_period();
+}
+
+std::shared_ptr<const GridSnapshot> GameOfLifeKernel::snapshot() const {
+    std::shared_ptr<GridSnapshot> result = std::make_shared<GridSnapshot>();
+    take_snapshot(result.get());
+    return result;
+}
+
+void GameOfLifeKernel::set_state(int **cells, long generation_) {
+    hash = 0;
+    population = 0;
+    for (int i = 0; i < config.rows; i++) {
+        uint64_t row_sum = 0;
+        for (int j = 0; j < config.cols; j++) {
+            xt0[i][j] = cells[i][j];
+            population += xt0[i][j];
+            row_sum += cell_term(col_keys[j], xt0[i][j]);
+        }
+        hash ^= row_hash(i, row_sum);
+    }
+    if (universe != nullptr) {
+        delete universe;
+        universe = new ChunkedUniverse(batches.size());
+        universe->copy_from(xt0, 0, 0, config.rows, config.cols);
+    }
+    // xt0 is complete, the sparse engine reloads it if the density is low.
+    sparse_active = false;
+    dense_stale = false;
+    mark_all_tiles_changed();
+    generation = generation_;
+    cycle_detector.reset();
+    cycle_detector.push(hash);
+}
+
+void GameOfLifeKernel::edit(int64_t row, int64_t col, int value) {
+    std::lock_guard<std::mutex> lock(edit_mutex);
+    queued_edits.push_back({row, col, value});
+}
+
+int GameOfLifeKernel::apply_edits() {
+    {
+        std::lock_guard<std::mutex> lock(edit_mutex);
+        if (queued_edits.empty())
+            return 0;
+        pending_edits.swap(queued_edits);
+    }
+    if (edit_log != nullptr)
+        edit_log->insert(edit_log->end(), pending_edits.begin(),
+                         pending_edits.end());
+    GOL_PROFILE_SCOPE("edits");
+    int n_edits = pending_edits.size();
+    if (universe != nullptr) {
+        universe->set_cells(pending_edits);
+        universe->copy_to(xt0, 0, 0, config.rows, config.cols);
+        mark_all_tiles_changed();
+        hash = universe->get_hash();
+        population = universe->get_population();
+    } else {
+        // Drop the edits outside the domain; sorting by row keeps later
+        // edits of a cell after earlier ones.
+        auto outside = [this](const CellEdit &e) {
+            return e.row < 0 || e.row >= config.rows || e.col < 0 ||
+                   e.col >= config.cols;
+        };
+        pending_edits.erase(std::remove_if(pending_edits.begin(),
+                                           pending_edits.end(), outside),
+                            pending_edits.end());
+        std::stable_sort(
+            pending_edits.begin(), pending_edits.end(),
+            [](const CellEdit &a, const CellEdit &b) { return a.row < b.row; });
+        if (sparse_active) {
+            sparse->set_cells(pending_edits);
+            hash = sparse->get_hash();
+            population = sparse->get_population();
+        }
+        // Without the sparse engine, or while xt0 is in sync with it, the
+        // edits go into xt0 and the hash is updated row by row.
+        bool write_dense = !sparse_active || !dense_stale;
+        if (!write_dense)
+            mark_all_tiles_changed();
+        for (size_t k = 0; write_dense && k < pending_edits.size();) {
+            const int i = pending_edits[k].row;
+            uint64_t old_sum = 0;
+            long old_population = 0;
+            for (int j = 0; j < config.cols; j++) {
+                old_sum += cell_term(col_keys[j], xt0[i][j]);
+                old_population += xt0[i][j];
+            }
+            for (; k < pending_edits.size() && pending_edits[k].row == i;
+                 k++) {
+                const int j = pending_edits[k].col;
+                xt0[i][j] = (pending_edits[k].value != 0);
+                mark_tile_changed(i, j);
+            }
+            if (sparse_active)
+                continue;
+            uint64_t new_sum = 0;
+            long new_population = 0;
+            for (int j = 0; j < config.cols; j++) {
+                new_sum += cell_term(col_keys[j], xt0[i][j]);
+                new_population += xt0[i][j];
+            }
+            hash ^= row_hash(i, old_sum) ^ row_hash(i, new_sum);
+            population += new_population - old_population;
+        }
+    }
+    pending_edits.clear();
+    // The earlier generations no longer lead to this one.
+    cycle_detector.reset();
+    cycle_detector.push(hash);
+    return n_edits;
+}
+
+void GameOfLifeKernel::set_edit_log(std::vector<CellEdit> *log) {
+    edit_log = log;
+}
+
+void GameOfLifeKernel::mark_tile_changed(int row, int col) {
+    tile_changed[(row / tile_h) * tile_cols + col / tile_w] = 1;
+    if (pyramid != nullptr)
+        pyramid_tiles[(row / tile_h) * tile_cols + col / tile_w] = 1;
+}
+
+void GameOfLifeKernel::mark_all_tiles_changed() {
+    std::fill(tile_changed.begin(), tile_changed.end(), 1);
+    std::fill(pyramid_tiles.begin(), pyramid_tiles.end(), 1);
+}
+
+void GameOfLifeKernel::update_pyramid_tiles() {
+    if (pyramid == nullptr)
+        return;
+    // Only the specialized dense sweep tracks the changed tiles.
+    if (config.kernel_variant != KERNEL_SPECIALIZED || sparse_active ||
+        universe != nullptr) {
+        std::fill(pyramid_tiles.begin(), pyramid_tiles.end(), 1);
+        return;
+    }
+    for (size_t k = 0; k < tile_changed.size(); k++)
+        pyramid_tiles[k] |= tile_changed[k];
+}
+
+const DensityPyramid *GameOfLifeKernel::get_pyramid() {
+    if (pyramid == nullptr)
+        return nullptr;
+    sync_dense();
+    // Runs of changed tiles in a tile row are marked as one rectangle.
+    for (int tr = 0; tr < tile_rows; tr++) {
+        uint8_t *changed = &pyramid_tiles[tr * tile_cols];
+        for (int tc = 0; tc < tile_cols;) {
+            if (!changed[tc]) {
+                tc++;
+                continue;
+            }
+            int end = tc;
+            while (end < tile_cols && changed[end])
+                changed[end++] = 0;
+            pyramid->mark(tr * tile_h, tc * tile_w, (tr + 1) * tile_h,
+                          end * tile_w);
+            tc = end;
+        }
+    }
+    pyramid->update(xt0);
+    return pyramid;
+}
+
+void GameOfLifeKernel::update_active_tiles() {
+    // A cell depends only on its neighbors, so a tile can only change if a
+    // tile in its 3x3 neighborhood changed.
+    for (int tr = 0; tr < tile_rows; tr++) {
+        for (int tc = 0; tc < tile_cols; tc++) {
+            uint8_t active = 0;
+            for (int r = std::max(0, tr - 1);
+                 r <= std::min(tile_rows - 1, tr + 1); r++)
+                for (int c = std::max(0, tc - 1);
+                     c <= std::min(tile_cols - 1, tc + 1); c++)
+                    active |= tile_changed[r * tile_cols + c];
+            tile_active[tr * tile_cols + tc] = active;
+        }
+    }
+}
+
+void GameOfLifeKernel::update_changed_tiles() {
+    std::fill(tile_changed.begin(), tile_changed.end(), 0);
+    for (int i = 1; i < config.rows - 1; i++) {
+        const uint8_t *changed = &segment_changed[(size_t)i * tile_cols];
+        uint8_t *tiles = &tile_changed[(i / tile_h) * tile_cols];
+        for (int tc = 0; tc < tile_cols; tc++)
+            tiles[tc] |= changed[tc];
+    }
+    // The perimeter is computed outside the tiles, compare it here.
+    const int last_row = config.rows - 1;
+    const int last_col = config.cols - 1;
+    for (int i = 0; i < config.rows; i++) {
+        for (int j : {0, last_col}) {
+            if (xt1[i][j] != xt0[i][j])
+                mark_tile_changed(i, j);
+        }
+    }
+    for (int i : {0, last_row}) {
+        for (int j = 0; j < config.cols; j++) {
+            if (xt1[i][j] != xt0[i][j])
+                mark_tile_changed(i, j);
+        }
+    }
+}
+
+long GameOfLifeKernel::get_generation() const { return generation; }
+
+long GameOfLifeKernel::get_population() const { return population; }
+
+uint64_t GameOfLifeKernel::get_hash() const { return hash; }
+
+int GameOfLifeKernel::get_period() const {
+    return cycle_detector.get_period();
+}
+
+Extent GameOfLifeKernel::get_extent() const {
+    if (universe != nullptr)
+        return universe->get_extent();
+    // Empty as in ChunkedUniverse: min_row > max_row.
+    Extent extent;
+    extent.min_row = std::numeric_limits<int64_t>::max();
+    extent.min_col = std::numeric_limits<int64_t>::max();
+    extent.max_row = std::numeric_limits<int64_t>::min();
+    extent.max_col = std::numeric_limits<int64_t>::min();
+    sync_dense();
+    for (int i = 0; i < config.rows; i++) {
+        int first = -1;
+        int last = -1;
+        for (int j = 0; j < config.cols; j++) {
+            if (xt0[i][j] != 0) {
+                if (first < 0)
+                    first = j;
+                last = j;
+            }
+        }
+        if (first < 0)
+            continue;
+        extent.min_row = std::min(extent.min_row, (int64_t)i);
+        extent.max_row = i;
+        extent.min_col = std::min(extent.min_col, (int64_t)first);
+        extent.max_col = std::max(extent.max_col, (int64_t)last);
+    }
+    return extent;
+}
+
 std::string GameOfLifeKernel::to_string() {
+    sync_dense();
     std::stringstream ss;
     for (int i = 0; i < config.rows; i++) {
         for (int j = 0; j < config.cols; j++) {
@@ -127,27 +576,39 @@ void GameOfLifeKernel::set_initial_conditions_in_subdomain(const int min_row,
     int sum = 0;
     // Will be used to obtain a seed for the random number engine
     std::random_device rd;
-    // Standard mersenne_twister_engine seeded with rd()
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<int> distribution(0, 1);
+    // Standard mersenne_twister_engine seeded with rd(), unless a seed is
+    // given for a reproducible run.
+    std::mt19937 gen(config.seed != 0 ? config.seed : rd());
+    std::bernoulli_distribution distribution(config.density);
     for (int i = min_row; i < max_row; i++) {
+        uint64_t row_sum = 0;
         for (int j = 0; j < config.cols; j++) {
             xt0[i][j] = distribution(gen);
             sum += xt0[i][j];
+            row_sum += cell_term(col_keys[j], xt0[i][j]);
         }
+        hash ^= row_hash(i, row_sum);
     }
+    population += sum;
     float fraction = (float)sum / (config.rows * config.cols);
-    std::cout << "Initial distribution: " << fraction << std::endl;
+    if (!config.quiet)
+        std::cout << "Initial distribution: " << fraction << std::endl;
 }
 
 void GameOfLifeKernel::timestep_subdomain(const int min_row,
                                           const int max_row) {
+    GOL_PROFILE_WORKER("worker", batch_index(min_row));
     // Loop over inner domain
     int min_col = 0;
     int max_col = config.cols - 1;
     for (int i = min_row; i < max_row; i++) {
+        row_sums[i] = 0;
+        row_populations[i] = 0;
         if (i == 0 || i >= config.rows - 1)
             continue;
+        // Hash the new state while it is still in cache.
+        uint64_t row_sum = 0;
+        long row_population = 0;
         for (int j = min_col; j < max_col; j++) {
             if (j == 0 || j >= config.cols - 1)
                 continue;
@@ -155,10 +616,73 @@ void GameOfLifeKernel::timestep_subdomain(const int min_row,
                       xt0[i][j - 1] + xt0[i][j + 1] + xt0[i + 1][j - 1] +
                       xt0[i + 1][j] + xt0[i + 1][j + 1];
             fx(i, j, sum);
+            row_sum += cell_term(col_keys[j], xt1[i][j]);
+            row_population += xt1[i][j];
+        }
+        row_sums[i] = row_sum;
+        row_populations[i] = row_population;
+    }
+}
+
+void GameOfLifeKernel::timestep_subdomain_specialized(const int min_row,
+                                                      const int max_row) {
+    GOL_PROFILE_WORKER("worker", batch_index(min_row));
+    const uint64_t *keys = col_keys.data();
+    for (int i = min_row; i < max_row; i++) {
+        row_sums[i] = 0;
+        row_populations[i] = 0;
+        if (i == 0 || i >= config.rows - 1)
+            continue;
+        const uint8_t *active = &tile_active[(i / tile_h) * tile_cols];
+        uint8_t *changed = &segment_changed[(size_t)i * tile_cols];
+        uint64_t *sums = &segment_sums[(size_t)i * tile_cols];
+        long *populations = &segment_populations[(size_t)i * tile_cols];
+        for (int tc = 0; tc < tile_cols; tc++) {
+            changed[tc] = 0;
+            if (!active[tc])
+                continue;
+            // Inner cells c0 .. c1 - 1 of the row segment in this tile.
+            const int c0 = std::max(1, tc * tile_w);
+            const int c1 = std::min(config.cols - 1, (tc + 1) * tile_w);
+            if (c0 >= c1) {
+                sums[tc] = 0;
+                populations[tc] = 0;
+                continue;
+            }
+            step_row<ConwayRule>(xt0[i - 1] + c0 - 1, xt0[i] + c0 - 1,
+                                 xt0[i + 1] + c0 - 1, xt1[i] + c0 - 1,
+                                 c1 - c0 + 2);
+            // Hash the new segment while it is still in cache.
+            const int *in = xt0[i];
+            const int *out = xt1[i];
+            uint64_t sum = 0;
+            long population = 0;
+            int diff = 0;
+            for (int j = c0; j < c1; j++) {
+                sum += cell_term(keys[j], out[j]);
+                population += out[j];
+                diff |= out[j] ^ in[j];
+            }
+            sums[tc] = sum;
+            populations[tc] = population;
+            changed[tc] = (diff != 0);
         }
+        uint64_t row_sum = 0;
+        long row_population = 0;
+        for (int tc = 0; tc < tile_cols; tc++) {
+            row_sum += sums[tc];
+            row_population += populations[tc];
+        }
+        row_sums[i] = row_sum;
+        row_populations[i] = row_population;
     }
 }
 
+template <int BT>
+void GameOfLifeKernel::apply_specialized_boundary_conditions() {
+    step_boundary<BT, ConwayRule>(xt0, xt1, config.rows, config.cols);
+}
+
 void GameOfLifeKernel::apply_constant_boundary_conditions() {
     int i, j, sum = 0;
     // compute edges
@@ -306,6 +830,40 @@ void GameOfLifeKernel::apply_mirror_boundary_conditions() {
     fx(i, j, sum);
 }
 
+void GameOfLifeKernel::hash_boundary() {
+    // Add the perimeter cells of xt1, which are computed serially after the
+    // inner domain, to the row sums.
+    const int last_row = config.rows - 1;
+    const int last_col = config.cols - 1;
+    for (int i = 1; i < last_row; i++) {
+        row_sums[i] += cell_term(col_keys[0], xt1[i][0]);
+        row_populations[i] += xt1[i][0];
+        if (last_col > 0) {
+            row_sums[i] += cell_term(col_keys[last_col], xt1[i][last_col]);
+            row_populations[i] += xt1[i][last_col];
+        }
+    }
+    for (int i : {0, last_row}) {
+        uint64_t row_sum = 0;
+        long row_population = 0;
+        for (int j = 0; j < config.cols; j++) {
+            row_sum += cell_term(col_keys[j], xt1[i][j]);
+            row_population += xt1[i][j];
+        }
+        row_sums[i] = row_sum;
+        row_populations[i] = row_population;
+    }
+}
+
+void GameOfLifeKernel::update_hash() {
+    hash = 0;
+    population = 0;
+    for (int i = 0; i < config.rows; i++) {
+        hash ^= row_hash(i, row_sums[i]);
+        population += row_populations[i];
+    }
+}
+
 void GameOfLifeKernel::fx(const int i, const int j, const int sum) {
     int value = xt0[i][j];
     int new_value = -1;
@@ -355,6 +913,14 @@ void GameOfLifeKernel::zeros(int **X) {
     }
 }
 
+int GameOfLifeKernel::batch_index(int min_row) const {
+    for (size_t t = 0; t < batches.size(); t++) {
+        if (std::get<0>(batches[t]) == min_row)
+            return t;
+    }
+    return -1;
+}
+
 void GameOfLifeKernel::batch_ranges(int n_samples, int n_batches) {
     // Don't try to make more batches than the total number of samples.
     if (n_batches >= n_samples - 2) {
@@ -0,0 +1,134 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#include "gol/GridArena.h"
+#include <cstdint>
+#include <new>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define GOL_HAVE_MMAP
+#endif
+
+static const size_t HUGE_PAGE_SIZE = (size_t)2 << 20;
+
+static size_t round_up(size_t n, size_t multiple) {
+    return (n + multiple - 1) / multiple * multiple;
+}
+
+GridArena::GridArena(bool huge_pages_)
+    : huge_pages(huge_pages_), base(nullptr), capacity(0),
+      backing(ARENA_NONE), zeroed(false) {}
+
+GridArena::~GridArena() { release(); }
+
+void *GridArena::acquire(size_t bytes) {
+    if (base != nullptr && bytes <= capacity) {
+        zeroed = false;
+        return base;
+    }
+    release();
+    if (bytes == 0)
+        bytes = 1;
+#ifdef GOL_HAVE_MMAP
+    size_t page = sysconf(_SC_PAGESIZE);
+    bool huge = huge_pages && bytes >= HUGE_PAGE_SIZE;
+    size_t size = round_up(bytes, huge ? HUGE_PAGE_SIZE : page);
+#ifdef MAP_HUGETLB
+    // Fails right away unless enough huge pages are reserved in
+    // /proc/sys/vm/nr_hugepages.
+    if (huge) {
+        void *p = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+            base = (char *)p;
+            capacity = size;
+            backing = ARENA_HUGETLB;
+            zeroed = true;
+            return base;
+        }
+    }
+#endif
+    // Map one huge page more than needed and trim it, so the block starts
+    // on a huge page boundary and every 2 MB of it can be a huge page.
+    size_t padding = huge ? HUGE_PAGE_SIZE : 0;
+    void *p = mmap(nullptr, size + padding, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p != MAP_FAILED) {
+        char *start = (char *)p;
+        char *aligned = start;
+        if (huge) {
+            aligned = (char *)round_up((uintptr_t)start, HUGE_PAGE_SIZE);
+            if (aligned > start)
+                munmap(start, aligned - start);
+            size_t tail = (start + size + padding) - (aligned + size);
+            if (tail > 0)
+                munmap(aligned + size, tail);
+        }
+        base = aligned;
+        capacity = size;
+        backing = ARENA_PAGES;
+#ifdef MADV_HUGEPAGE
+        if (huge && madvise(base, size, MADV_HUGEPAGE) == 0)
+            backing = ARENA_TRANSPARENT_HUGE_PAGES;
+#endif
+        zeroed = true;
+        return base;
+    }
+#endif
+    base = (char *)::operator new(bytes);
+    capacity = bytes;
+    backing = ARENA_HEAP;
+    zeroed = false;
+    return base;
+}
+
+void GridArena::release() {
+    if (base == nullptr)
+        return;
+#ifdef GOL_HAVE_MMAP
+    if (backing != ARENA_HEAP)
+        munmap(base, capacity);
+    else
+        ::operator delete(base);
+#else
+    ::operator delete(base);
+#endif
+    base = nullptr;
+    capacity = 0;
+    backing = ARENA_NONE;
+    zeroed = false;
+}
+
+bool GridArena::is_zeroed() const { return zeroed; }
+
+int GridArena::get_backing() const { return backing; }
+
+size_t GridArena::get_capacity() const { return capacity; }
+
+const char *GridArena::backing_name(int backing) {
+    switch (backing) {
+    case ARENA_HEAP:
+        return "heap";
+    case ARENA_PAGES:
+        return "pages";
+    case ARENA_TRANSPARENT_HUGE_PAGES:
+        return "transparent huge pages";
+    case ARENA_HUGETLB:
+        return "hugetlb";
+    default:
+        return "none";
+    }
+}
@@ -0,0 +1,69 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#include "gol/GridSnapshot.h"
+#include "gol/GameOfLifeKernel.h"
+#include <sstream>
+
+GridSnapshot::GridSnapshot(int rows_, int cols_)
+    : rows(0), cols(0), generation(0), population(0), hash(0), period(0) {
+    resize(rows_, cols_);
+}
+
+GridSnapshot::~GridSnapshot() {}
+
+void GridSnapshot::resize(int rows_, int cols_) {
+    if (rows_ == rows && cols_ == cols)
+        return;
+    rows = rows_;
+    cols = cols_;
+    cells.assign((size_t)rows * cols, 0);
+    xt.resize(rows);
+    for (int i = 0; i < rows; i++)
+        xt[i] = cells.data() + (size_t)i * cols;
+}
+
+long GridSnapshot::get_generation() const { return generation; }
+
+long GridSnapshot::get_population() const { return population; }
+
+uint64_t GridSnapshot::get_hash() const { return hash; }
+
+int GridSnapshot::get_period() const { return period; }
+
+int GridSnapshot::get_rows() const { return rows; }
+
+int GridSnapshot::get_cols() const { return cols; }
+
+int GridSnapshot::get_xt_at(int row, int col) const {
+    return cells[(size_t)row * cols + col];
+}
+
+int **GridSnapshot::get_xt() const { return const_cast<int **>(xt.data()); }
+
+const int *GridSnapshot::get_buffer(int *stride) const {
+    *stride = cols;
+    return cells.data();
+}
+
+std::string GridSnapshot::to_string() const {
+    std::stringstream ss;
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            ss << ((xt[i][j] == 1) ? CELL_ALIVE : CELL_DEAD);
+        }
+        ss << std::endl;
+    }
+    return ss.str();
+}
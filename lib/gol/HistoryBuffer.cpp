@@ -0,0 +1,154 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#include "gol/HistoryBuffer.h"
+#include "gol/RunLength.h"
+
+#include <algorithm>
+
+HistoryBuffer::HistoryBuffer(int rows, int cols, size_t max_bytes,
+                             int keyframe_interval)
+    : rows(rows), cols(cols), max_bytes(max_bytes),
+      keyframe_interval(std::max(1, keyframe_interval)), bytes(0),
+      since_key(0) {
+    words_per_row = (cols + 63) / 64;
+    last.assign((size_t)rows * words_per_row, 0);
+    packed.assign((size_t)rows * words_per_row, 0);
+}
+
+HistoryBuffer::~HistoryBuffer() {}
+
+void HistoryBuffer::pack(int **xt, std::vector<uint64_t> &out) const {
+    for (int i = 0; i < rows; i++) {
+        uint64_t *words = &out[(size_t)i * words_per_row];
+        for (int w = 0; w < words_per_row; w++) {
+            uint64_t word = 0;
+            int j0 = w * 64;
+            int n = std::min(64, cols - j0);
+            for (int b = 0; b < n; b++)
+                word |= (uint64_t)(xt[i][j0 + b] != 0) << b;
+            words[w] = word;
+        }
+    }
+}
+
+void HistoryBuffer::unpack(const std::vector<uint64_t> &in, int **xt) const {
+    for (int i = 0; i < rows; i++) {
+        const uint64_t *words = &in[(size_t)i * words_per_row];
+        for (int j = 0; j < cols; j++)
+            xt[i][j] = (words[j >> 6] >> (j & 63)) & 1;
+    }
+}
+
+void HistoryBuffer::push(int **xt, long generation) {
+    if (!entries.empty() && generation <= entries.back().generation)
+        truncate_after(generation - 1);
+    pack(xt, packed);
+    HistoryEntry entry;
+    entry.generation = generation;
+    entry.key = entries.empty() || since_key + 1 >= keyframe_interval;
+    const uint8_t *in = (const uint8_t *)packed.data();
+    size_t n = packed.size() * sizeof(uint64_t);
+    if (entry.key) {
+        rle_encode(in, n, entry.data);
+        since_key = 0;
+    } else {
+        for (size_t k = 0; k < last.size(); k++)
+            last[k] ^= packed[k];
+        rle_encode((const uint8_t *)last.data(), n, entry.data);
+        since_key++;
+    }
+    entry.data.shrink_to_fit();
+    bytes += entry.data.size();
+    entries.push_back(std::move(entry));
+    last.swap(packed);
+    evict();
+}
+
+void HistoryBuffer::evict() {
+    // Deltas can't be decoded without their keyframe, so the oldest
+    // keyframe goes together with all its deltas, and the newest keyframe
+    // is always kept.
+    while (bytes > max_bytes) {
+        size_t next = 1;
+        while (next < entries.size() && !entries[next].key)
+            next++;
+        if (next >= entries.size())
+            break;
+        for (size_t k = 0; k < next; k++) {
+            bytes -= entries.front().data.size();
+            entries.pop_front();
+        }
+    }
+}
+
+size_t HistoryBuffer::find(long generation) const {
+    auto it = std::lower_bound(
+        entries.begin(), entries.end(), generation,
+        [](const HistoryEntry &entry, long g) { return entry.generation < g; });
+    if (it == entries.end() || it->generation != generation)
+        return entries.size();
+    return it - entries.begin();
+}
+
+void HistoryBuffer::decode(size_t index, std::vector<uint64_t> &out) const {
+    size_t key = index;
+    while (!entries[key].key)
+        key--;
+    uint8_t *cells = (uint8_t *)out.data();
+    size_t n = out.size() * sizeof(uint64_t);
+    rle_decode(entries[key].data.data(), entries[key].data.size(), cells, n);
+    for (size_t k = key + 1; k <= index; k++)
+        rle_decode_xor(entries[k].data.data(), entries[k].data.size(), cells,
+                       n);
+}
+
+bool HistoryBuffer::restore(long generation, int **xt) {
+    size_t index = find(generation);
+    if (index == entries.size())
+        return false;
+    decode(index, packed);
+    unpack(packed, xt);
+    return true;
+}
+
+void HistoryBuffer::truncate_after(long generation) {
+    bool changed = false;
+    while (!entries.empty() && entries.back().generation > generation) {
+        bytes -= entries.back().data.size();
+        entries.pop_back();
+        changed = true;
+    }
+    if (!changed || entries.empty()) {
+        if (entries.empty())
+            since_key = 0;
+        return;
+    }
+    // The newest entry is the base of the next delta again.
+    size_t index = entries.size() - 1;
+    decode(index, last);
+    since_key = 0;
+    while (!entries[index - since_key].key)
+        since_key++;
+}
+
+long HistoryBuffer::get_first_generation() const {
+    return entries.empty() ? -1 : entries.front().generation;
+}
+
+long HistoryBuffer::get_last_generation() const {
+    return entries.empty() ? -1 : entries.back().generation;
+}
+
+size_t HistoryBuffer::get_bytes() const { return bytes; }
@@ -0,0 +1,186 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#include "gol/Profiler.h"
+
+#ifdef GOL_PROFILING
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <vector>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static std::atomic<bool> profiler_enabled(false);
+static std::atomic<bool> profiler_counters(false);
+static std::mutex events_mutex;
+static std::vector<ProfileEvent> events;
+static const std::chrono::steady_clock::time_point epoch =
+    std::chrono::steady_clock::now();
+
+// Events are buffered per thread without locking and handed over to the
+// global list when the thread exits or the trace is written.
+struct ThreadEvents {
+    std::vector<ProfileEvent> buffer;
+
+    void flush() {
+        std::lock_guard<std::mutex> lock(events_mutex);
+        events.insert(events.end(), buffer.begin(), buffer.end());
+        buffer.clear();
+    }
+
+    ~ThreadEvents() { flush(); }
+};
+
+static thread_local ThreadEvents thread_events;
+
+// Counters belong to the thread that opens them. The kernel starts new
+// worker threads every step, so every worker opens its counters with its
+// first scope and closes them when it exits: two perf_event_open and two
+// close calls per worker and step. The opening happens before the start of
+// that first scope is taken, so the worker spans and their counts leave it
+// out, but the enclosing "interior" span includes it.
+static PerfCounters *thread_counters() {
+    static thread_local PerfCounters counters;
+    return &counters;
+}
+
+void Profiler::enable(bool with_counters) {
+    events.reserve(1 << 16);
+    profiler_enabled = true;
+    if (with_counters) {
+        profiler_counters = thread_counters()->is_open();
+        if (!profiler_counters) {
+            std::cout << "--- Hardware counters are not available, check "
+                         "/proc/sys/kernel/perf_event_paranoid."
+                      << std::endl;
+        }
+    }
+}
+
+bool Profiler::is_enabled() { return profiler_enabled; }
+
+bool Profiler::has_counters() { return profiler_counters; }
+
+uint64_t Profiler::now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - epoch)
+        .count();
+}
+
+void Profiler::record(const ProfileEvent &event) {
+    thread_events.buffer.push_back(event);
+}
+
+bool Profiler::write_chrome_trace(const std::string &filename) {
+    thread_events.flush();
+    std::ofstream file(filename);
+    if (!file.is_open())
+        return false;
+    std::lock_guard<std::mutex> lock(events_mutex);
+    file << std::fixed << std::setprecision(3);
+    file << "{\"traceEvents\":[" << std::endl;
+    for (size_t i = 0; i < events.size(); i++) {
+        const ProfileEvent &e = events[i];
+        file << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":1"
+             << ",\"tid\":" << e.track << ",\"ts\":" << e.start_ns / 1000.0
+             << ",\"dur\":" << e.duration_ns / 1000.0;
+        if (e.cycles >= 0) {
+            file << ",\"args\":{\"cycles\":" << e.cycles
+                 << ",\"cache_misses\":" << e.cache_misses << "}";
+        }
+        file << "}" << (i + 1 < events.size() ? "," : "") << std::endl;
+    }
+    file << "]}" << std::endl;
+    return true;
+}
+
+PerfCounters::PerfCounters() : fd_cycles(-1), fd_cache_misses(-1) {
+#if defined(__linux__)
+    struct perf_event_attr attr = {};
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.config = PERF_COUNT_HW_CPU_CYCLES;
+    fd_cycles = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if (fd_cycles < 0)
+        return;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    fd_cache_misses = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if (fd_cache_misses < 0) {
+        close(fd_cycles);
+        fd_cycles = -1;
+    }
+#endif
+}
+
+PerfCounters::~PerfCounters() {
+#if defined(__linux__)
+    if (fd_cycles >= 0)
+        close(fd_cycles);
+    if (fd_cache_misses >= 0)
+        close(fd_cache_misses);
+#endif
+}
+
+bool PerfCounters::is_open() const { return fd_cycles >= 0; }
+
+void PerfCounters::read(int64_t *cycles, int64_t *cache_misses) {
+    *cycles = -1;
+    *cache_misses = -1;
+#if defined(__linux__)
+    uint64_t value;
+    if (::read(fd_cycles, &value, sizeof(value)) == sizeof(value))
+        *cycles = value;
+    if (::read(fd_cache_misses, &value, sizeof(value)) == sizeof(value))
+        *cache_misses = value;
+#endif
+}
+
+ProfileScope::ProfileScope(const char *name, int worker)
+    : active(profiler_enabled) {
+    if (!active)
+        return;
+    event.name = name;
+    event.track = worker + 1;
+    event.cycles = -1;
+    event.cache_misses = -1;
+    if (profiler_counters)
+        thread_counters()->read(&event.cycles, &event.cache_misses);
+    event.start_ns = Profiler::now_ns();
+}
+
+ProfileScope::~ProfileScope() {
+    if (!active)
+        return;
+    event.duration_ns = Profiler::now_ns() - event.start_ns;
+    if (profiler_counters && event.cycles >= 0) {
+        int64_t cycles, cache_misses;
+        thread_counters()->read(&cycles, &cache_misses);
+        event.cycles = cycles - event.cycles;
+        event.cache_misses = cache_misses - event.cache_misses;
+    }
+    Profiler::record(event);
+}
+
+#endif
@@ -0,0 +1,172 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#include "gol/SparseUniverse.h"
+#include "gol/CellHash.h"
+#include "gol/GameOfLifeKernel.h"
+#include "gol/Profiler.h"
+#include <algorithm>
+
+// Row in the high word, so the packed cells sort in row major order.
+static inline uint64_t pack(uint32_t row, uint32_t col) {
+    return ((uint64_t)row << 32) | col;
+}
+
+static inline int unpack_row(uint64_t cell) { return (int)(cell >> 32); }
+
+static inline int unpack_col(uint64_t cell) {
+    return (int)(cell & 0xffffffff);
+}
+
+SparseUniverse::SparseUniverse(int rows_, int cols_, int boundary_type_)
+    : rows(rows_), cols(cols_), boundary_type(boundary_type_), hash(0) {}
+
+void SparseUniverse::load(int **xt) {
+    cells.clear();
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            if (xt[i][j] != 0)
+                cells.push_back(pack(i, j));
+        }
+    }
+    update_hash();
+}
+
+void SparseUniverse::timestep() {
+    GOL_PROFILE_SCOPE("sparse");
+    contributions.clear();
+    contributions.reserve(8 * cells.size());
+    for (uint64_t cell : cells) {
+        add_contributions(cell);
+    }
+    std::sort(contributions.begin(), contributions.end());
+    // Walk the runs of equal coordinates together with the live cells; both
+    // are sorted, so the new generation comes out sorted too.
+    next_cells.clear();
+    size_t live = 0;
+    size_t k = 0;
+    while (k < contributions.size()) {
+        const uint64_t cell = contributions[k];
+        size_t end = k + 1;
+        while (end < contributions.size() && contributions[end] == cell)
+            end++;
+        const int sum = end - k;
+        while (live < cells.size() && cells[live] < cell)
+            live++;
+        const bool alive = live < cells.size() && cells[live] == cell;
+        if (sum == 3 || (sum == 2 && alive))
+            next_cells.push_back(cell);
+        k = end;
+    }
+    cells.swap(next_cells);
+    update_hash();
+}
+
+void SparseUniverse::set_in(int **xt) const {
+    for (uint64_t cell : cells) {
+        xt[unpack_row(cell)][unpack_col(cell)] = 1;
+    }
+}
+
+void SparseUniverse::clear_in(int **xt) const {
+    for (uint64_t cell : cells) {
+        xt[unpack_row(cell)][unpack_col(cell)] = 0;
+    }
+}
+
+void SparseUniverse::set_cell(int row, int col, int value) {
+    const uint64_t cell = pack(row, col);
+    auto it = std::lower_bound(cells.begin(), cells.end(), cell);
+    const bool alive = it != cells.end() && *it == cell;
+    if (value != 0 && !alive)
+        cells.insert(it, cell);
+    else if (value == 0 && alive)
+        cells.erase(it);
+    update_hash();
+}
+
+void SparseUniverse::set_cells(const std::vector<CellEdit> &edits) {
+    // Keep the last edit of every cell, ordered by cell.
+    std::vector<std::pair<uint64_t, int>> sorted;
+    sorted.reserve(edits.size());
+    for (const CellEdit &edit : edits) {
+        if (edit.row < 0 || edit.row >= rows || edit.col < 0 ||
+            edit.col >= cols)
+            continue;
+        sorted.push_back({pack(edit.row, edit.col), edit.value != 0});
+    }
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const std::pair<uint64_t, int> &a,
+                        const std::pair<uint64_t, int> &b) {
+                         return a.first < b.first;
+                     });
+    // Merge the sorted edits into the sorted live cells.
+    next_cells.clear();
+    size_t i = 0;
+    for (size_t k = 0; k < sorted.size(); k++) {
+        if (k + 1 < sorted.size() && sorted[k + 1].first == sorted[k].first)
+            continue;
+        while (i < cells.size() && cells[i] < sorted[k].first)
+            next_cells.push_back(cells[i++]);
+        if (i < cells.size() && cells[i] == sorted[k].first)
+            i++;
+        if (sorted[k].second)
+            next_cells.push_back(sorted[k].first);
+    }
+    next_cells.insert(next_cells.end(), cells.begin() + i, cells.end());
+    cells.swap(next_cells);
+    update_hash();
+}
+
+long SparseUniverse::get_population() const { return cells.size(); }
+
+uint64_t SparseUniverse::get_hash() const { return hash; }
+
+void SparseUniverse::add_contributions(uint64_t cell) {
+    const int row = unpack_row(cell);
+    const int col = unpack_col(cell);
+    const bool periodic = boundary_type != BOUNDARY_CONSTANT;
+    for (int dr = -1; dr <= 1; dr++) {
+        int r = row + dr;
+        if (r < 0 || r >= rows) {
+            if (!periodic)
+                continue;
+            r = (r < 0) ? rows - 1 : 0;
+        }
+        for (int dc = -1; dc <= 1; dc++) {
+            if (dr == 0 && dc == 0)
+                continue;
+            int c = col + dc;
+            if (c < 0 || c >= cols) {
+                if (!periodic)
+                    continue;
+                c = (c < 0) ? cols - 1 : 0;
+            }
+            contributions.push_back(pack(r, c));
+        }
+    }
+}
+
+void SparseUniverse::update_hash() {
+    hash = 0;
+    size_t k = 0;
+    while (k < cells.size()) {
+        const int row = unpack_row(cells[k]);
+        uint64_t row_sum = 0;
+        for (; k < cells.size() && unpack_row(cells[k]) == row; k++) {
+            row_sum += column_key(unpack_col(cells[k]));
+        }
+        hash ^= row_hash(row, row_sum);
+    }
+}
@@ -0,0 +1,153 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#include "gol/StepAhead.h"
+#include <vector>
+
+// Snapshots that are not held by anyone. A handed-out snapshot keeps the
+// pool alive through its deleter, so it can outlive the StepAhead.
+class SnapshotPool : public std::enable_shared_from_this<SnapshotPool> {
+  public:
+    virtual ~SnapshotPool() {
+        for (GridSnapshot *snapshot : free)
+            delete snapshot;
+    }
+
+    std::shared_ptr<GridSnapshot> acquire() {
+        GridSnapshot *snapshot = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!free.empty()) {
+                snapshot = free.back();
+                free.pop_back();
+            }
+        }
+        if (snapshot == nullptr)
+            snapshot = new GridSnapshot();
+        std::shared_ptr<SnapshotPool> self = shared_from_this();
+        return std::shared_ptr<GridSnapshot>(
+            snapshot, [self](GridSnapshot *s) { self->release(s); });
+    }
+
+  private:
+    std::mutex mutex;
+    std::vector<GridSnapshot *> free;
+
+    void release(GridSnapshot *snapshot) {
+        std::lock_guard<std::mutex> lock(mutex);
+        free.push_back(snapshot);
+    }
+};
+
+StepAhead::StepAhead(GameOfLifeKernel *kernel_, int depth_,
+                     long last_generation_)
+    : kernel(kernel_), depth(depth_ > 0 ? depth_ : 1),
+      last_generation(last_generation_),
+      pool(std::make_shared<SnapshotPool>()), stopping(false), done(false) {
+    kernel->set_edit_log(&step_edits);
+    worker = std::thread(&StepAhead::run, this);
+}
+
+StepAhead::~StepAhead() {
+    stop();
+    kernel->set_edit_log(nullptr);
+}
+
+void StepAhead::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    room.notify_all();
+    if (worker.joinable())
+        worker.join();
+}
+
+void StepAhead::rewind(const GridSnapshot &shown) {
+    stop();
+    // Edits still in the queue are logged as they are applied to the
+    // generation that is dropped.
+    kernel->apply_edits();
+    kernel->set_edit_log(nullptr);
+    std::vector<CellEdit> edits;
+    for (const auto &applied : applied_edits) {
+        if (applied.first > shown.get_generation())
+            edits.insert(edits.end(), applied.second.begin(),
+                         applied.second.end());
+    }
+    edits.insert(edits.end(), step_edits.begin(), step_edits.end());
+    applied_edits.clear();
+    step_edits.clear();
+    ready.clear();
+    done = true;
+    kernel->set_state(shown.get_xt(), shown.get_generation());
+    for (const CellEdit &e : edits)
+        kernel->edit(e.row, e.col, e.value);
+}
+
+std::shared_ptr<const GridSnapshot> StepAhead::next() {
+    std::unique_lock<std::mutex> lock(mutex);
+    filled.wait(lock, [this] { return !ready.empty() || done; });
+    if (ready.empty())
+        return nullptr;
+    std::shared_ptr<const GridSnapshot> snapshot = ready.front();
+    ready.pop_front();
+    // The edits of this generation are on screen from now on.
+    while (!applied_edits.empty() &&
+           applied_edits.front().first <= snapshot->get_generation())
+        applied_edits.pop_front();
+    lock.unlock();
+    room.notify_one();
+    return snapshot;
+}
+
+int StepAhead::get_ready() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return ready.size();
+}
+
+void StepAhead::run() {
+    bool first = true;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            room.wait(lock, [this] {
+                return stopping || (int)ready.size() < depth;
+            });
+            if (stopping)
+                break;
+        }
+        // The kernel is only touched outside the lock, so the consumer
+        // can take the ready generations meanwhile.
+        if (!first)
+            kernel->timestep();
+        first = false;
+        std::shared_ptr<GridSnapshot> snapshot = pool->acquire();
+        kernel->take_snapshot(snapshot.get());
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!step_edits.empty()) {
+            applied_edits.emplace_back(snapshot->get_generation(),
+                                       std::move(step_edits));
+            step_edits.clear();
+        }
+        ready.push_back(snapshot);
+        filled.notify_one();
+        if (last_generation >= 0 &&
+            snapshot->get_generation() >= last_generation)
+            break;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    done = true;
+    filled.notify_all();
+}
@@ -0,0 +1,174 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#include <exception>
+#include <string>
+
+#include "gol/GameOfLifeKernel.h"
+#include "gol/gol_c.h"
+
+struct gol_kernel {
+    GameOfLifeKernel *kernel;
+    gol_callback callback;
+    void *user_data;
+};
+
+static thread_local std::string last_error;
+
+static int fail(const char *message) {
+    last_error = message;
+    return -1;
+}
+
+int gol_api_version(void) { return GOL_API_VERSION; }
+
+gol_config gol_config_default(void) {
+    gol_config config;
+    config.rows = 200;
+    config.cols = 320;
+    config.boundary_type = BOUNDARY_PERIODIC;
+    config.kernel_variant = KERNEL_SPECIALIZED;
+    config.with_threads = 1;
+    config.seed = 0;
+    config.density = 0.5;
+    config.sparse_density = 0.01;
+    return config;
+}
+
+gol_kernel *gol_create(const gol_config *c) {
+    if (c == nullptr) {
+        fail("gol_create: config is NULL");
+        return nullptr;
+    }
+    if (c->rows < 3 || c->cols < 3) {
+        fail("gol_create: the domain must be at least 3x3");
+        return nullptr;
+    }
+    if (c->boundary_type < BOUNDARY_CONSTANT ||
+        c->boundary_type > BOUNDARY_UNBOUNDED) {
+        fail("gol_create: unknown boundary type");
+        return nullptr;
+    }
+    if (c->kernel_variant < KERNEL_GENERIC ||
+        c->kernel_variant > KERNEL_SPECIALIZED) {
+        fail("gol_create: unknown kernel variant");
+        return nullptr;
+    }
+    Config config;
+    config.rows = c->rows;
+    config.cols = c->cols;
+    config.n_steps = 0;
+    config.boundary_type = c->boundary_type;
+    config.display_w = c->cols;
+    config.display_h = c->rows;
+    config.zoom_factor = 1;
+    config.with_threads = c->with_threads != 0;
+    config.mode_fullscreen = false;
+    config.on_cycle = CYCLE_CONTINUE;
+    config.ensemble_size = 1;
+    config.seed = c->seed;
+    config.kernel_variant = c->kernel_variant;
+    config.density = c->density;
+    config.sparse_density = c->sparse_density;
+    config.quiet = true;
+    config.headless = true;
+    config.export_format = 0;
+    config.export_every = 1;
+    config.history_mb = 0;
+    config.n_threads = 0;
+    config.tile_h = 0;
+    config.tile_w = 0;
+    config.autotune = AUTOTUNE_OFF;
+    config.step_ahead = 0;
+    config.density_pyramid = false;
+    config.zoom_out = 1;
+    try {
+        gol_kernel *k = new gol_kernel;
+        k->callback = nullptr;
+        k->user_data = nullptr;
+        try {
+            k->kernel = new GameOfLifeKernel(config);
+        } catch (...) {
+            delete k;
+            throw;
+        }
+        last_error.clear();
+        return k;
+    } catch (const std::exception &e) {
+        fail(e.what());
+    } catch (...) {
+        fail("gol_create: unknown error");
+    }
+    return nullptr;
+}
+
+void gol_destroy(gol_kernel *k) {
+    if (k == nullptr)
+        return;
+    delete k->kernel;
+    delete k;
+}
+
+int gol_step(gol_kernel *k, int n) {
+    if (k == nullptr)
+        return fail("gol_step: kernel is NULL");
+    try {
+        for (int i = 0; i < n; i++) {
+            k->kernel->timestep();
+            if (k->callback != nullptr &&
+                k->callback(k, k->kernel->get_generation(), k->user_data))
+                return i + 1;
+        }
+    } catch (const std::exception &e) {
+        return fail(e.what());
+    } catch (...) {
+        return fail("gol_step: unknown error");
+    }
+    return n < 0 ? 0 : n;
+}
+
+int gol_get_stats(const gol_kernel *k, gol_stats *stats) {
+    if (k == nullptr || stats == nullptr)
+        return fail("gol_get_stats: kernel or stats is NULL");
+    stats->generation = k->kernel->get_generation();
+    stats->population = k->kernel->get_population();
+    stats->hash = k->kernel->get_hash();
+    stats->period = k->kernel->get_period();
+    return 0;
+}
+
+const int *gol_get_buffer(gol_kernel *k, int *rows, int *cols, int *stride) {
+    if (k == nullptr) {
+        fail("gol_get_buffer: kernel is NULL");
+        return nullptr;
+    }
+    int s;
+    const int *buffer = k->kernel->get_buffer(&s);
+    if (rows != nullptr)
+        *rows = k->kernel->get_rows();
+    if (cols != nullptr)
+        *cols = k->kernel->get_cols();
+    if (stride != nullptr)
+        *stride = s;
+    return buffer;
+}
+
+void gol_set_callback(gol_kernel *k, gol_callback callback, void *user_data) {
+    if (k == nullptr)
+        return;
+    k->callback = callback;
+    k->user_data = user_data;
+}
+
+const char *gol_last_error(void) { return last_error.c_str(); }
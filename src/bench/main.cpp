@@ -0,0 +1,357 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gol/CellHash.h"
+#include "gol/GridArena.h"
+#include "gol/Kernels.h"
+#include "gol/Rules.h"
+#include "gol/StepAhead.h"
+#include "main.h"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static bool alloc_mode = false;
+
+int parse_arguments(std::vector<std::string> args, Config *config) {
+    for (auto i = args.begin(); i != args.end(); ++i) {
+        if (*i == "-h" || *i == "--help") {
+            std::cout << "game-of-life-bench" << std::endl;
+            std::cout << "   --width <number>      : width of the domain, "
+                         "default = 2048."
+                      << std::endl;
+            std::cout << "   --height <number>     : height of the domain, "
+                         "default = 2048."
+                      << std::endl;
+            std::cout
+                << "   --steps <number>      : number of steps, default = 100."
+                << std::endl;
+            std::cout << "   --bt <number>         : boundary type: 0=const, "
+                         "1=periodic, 2=mirror, 3=unbounded, default=1."
+                      << std::endl;
+            std::cout << "   --seed <number>       : seed of the initial "
+                         "conditions, default = 1."
+                      << std::endl;
+            std::cout << "   --density <number>    : fraction of live cells in "
+                         "the initial conditions, default = 0.5."
+                      << std::endl;
+            std::cout << "   --alloc               : time construction and "
+                         "stepping with small and huge pages instead."
+                      << std::endl;
+            std::cout << "   --without-threads     : compute single threaded."
+                      << std::endl;
+            std::cout << "   -h, --help            : info and help message."
+                      << std::endl;
+            exit(0);
+        } else if (*i == "--width") {
+            config->cols = stoi(*++i);
+        } else if (*i == "--height") {
+            config->rows = stoi(*++i);
+        } else if (*i == "--steps") {
+            config->n_steps = stoi(*++i);
+        } else if (*i == "--bt") {
+            config->boundary_type = stoi(*++i);
+        } else if (*i == "--seed") {
+            config->seed = stoul(*++i);
+        } else if (*i == "--density") {
+            config->density = stof(*++i);
+        } else if (*i == "--alloc") {
+            alloc_mode = true;
+        } else if (*i == "--without-threads") {
+            config->with_threads = false;
+        }
+    }
+    return 0;
+}
+
+void print_result(const std::string &name, const Config &config,
+                  double seconds, uint64_t hash) {
+    double cells = (double)config.rows * config.cols * config.n_steps;
+    std::cout << std::left << std::setw(28) << name << std::right
+              << std::fixed << std::setprecision(3) << std::setw(10)
+              << 1000.0 * seconds / config.n_steps << " ms/step"
+              << std::setw(10) << cells / seconds / 1e6 << " Mcells/s"
+              << "   hash " << std::hex << hash << std::dec << std::endl;
+}
+
+uint64_t bench_kernel(Config config, const std::string &name) {
+    GameOfLifeKernel *kernel = new GameOfLifeKernel(config);
+    auto t0 = std::chrono::steady_clock::now();
+    for (int step = 0; step < config.n_steps; step++) {
+        kernel->timestep();
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    uint64_t hash = kernel->get_hash();
+    delete kernel;
+    print_result(config.with_threads ? name : name + " 1t", config, std::chrono::duration<double>(t1 - t0).count(),
+                 hash);
+    return hash;
+}
+
+bool check_ahead_edits(Config config) {
+    // A 2x2 block painted on an empty grid while generations are computed
+    // ahead, then a pause: the block must survive the rewind to the
+    // generation on screen.
+    config.rows = 64;
+    config.cols = 64;
+    config.density = 0;
+    config.sparse_density = 0;
+    const int depth = 4;
+    GameOfLifeKernel *kernel = new GameOfLifeKernel(config);
+    StepAhead *ahead = new StepAhead(kernel, depth);
+    ahead->next();
+    while (ahead->get_ready() < depth)
+        std::this_thread::yield();
+    for (int i = 10; i < 12; i++) {
+        for (int j = 10; j < 12; j++) {
+            kernel->edit(i, j, 1);
+        }
+    }
+    std::shared_ptr<const GridSnapshot> shown = ahead->next();
+    while (ahead->get_ready() < depth)
+        std::this_thread::yield();
+    ahead->rewind(*shown);
+    delete ahead;
+    kernel->apply_edits();
+    bool kept = kernel->get_generation() == shown->get_generation() &&
+                kernel->get_population() == 4;
+    delete kernel;
+    return kept;
+}
+
+// Counts the data TLB misses of the process and of the threads it starts
+// from now on. Returns -1 if perf events are not available.
+static int open_tlb_counter() {
+#if defined(__linux__)
+    struct perf_event_attr attr = {};
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.inherit = 1;
+    return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    return -1;
+#endif
+}
+
+static int64_t read_counter(int fd) {
+#if defined(__linux__)
+    uint64_t value;
+    if (fd >= 0 && read(fd, &value, sizeof(value)) == sizeof(value))
+        return value;
+#endif
+    return -1;
+}
+
+static void close_counter(int fd) {
+#if defined(__linux__)
+    if (fd >= 0)
+        close(fd);
+#endif
+}
+
+// Times the construction, the steps and the destruction of a kernel whose
+// buffers come from the given arena.
+uint64_t bench_alloc(Config config, GridArena *arena, const std::string &name) {
+    auto t0 = std::chrono::steady_clock::now();
+    GameOfLifeKernel *kernel = new GameOfLifeKernel(config, arena);
+    auto t1 = std::chrono::steady_clock::now();
+    int fd = open_tlb_counter();
+    int64_t misses0 = read_counter(fd);
+    for (int step = 0; step < config.n_steps; step++) {
+        kernel->timestep();
+    }
+    int64_t misses1 = read_counter(fd);
+    close_counter(fd);
+    auto t2 = std::chrono::steady_clock::now();
+    uint64_t hash = kernel->get_hash();
+    delete kernel;
+    auto t3 = std::chrono::steady_clock::now();
+    std::cout << std::left << std::setw(22) << name << std::setw(24)
+              << GridArena::backing_name(arena->get_backing()) << std::right
+              << std::fixed << std::setprecision(3) << std::setw(10)
+              << std::chrono::duration<double, std::milli>(t1 - t0).count()
+              << " ms init" << std::setw(10)
+              << std::chrono::duration<double, std::milli>(t2 - t1).count() /
+                     config.n_steps
+              << " ms/step" << std::setw(10)
+              << std::chrono::duration<double, std::milli>(t3 - t2).count()
+              << " ms free";
+    if (misses0 >= 0 && misses1 >= 0)
+        std::cout << std::setw(14) << (misses1 - misses0) / config.n_steps
+                  << " dTLB misses/step";
+    std::cout << std::endl;
+    return hash;
+}
+
+template <int BT, typename Cell>
+void step_n(std::vector<Cell *> &x0, std::vector<Cell *> &x1,
+            const Config &config) {
+    for (int step = 0; step < config.n_steps; step++) {
+        for (int i = 1; i < config.rows - 1; i++) {
+            step_row<ConwayRule>(x0[i - 1], x0[i], x0[i + 1], x1[i],
+                                 config.cols);
+        }
+        step_boundary<BT, ConwayRule>(x0.data(), x1.data(), config.rows,
+                                      config.cols);
+        x0.swap(x1);
+    }
+}
+
+// Steps a copy of the initial conditions single threaded with the given cell
+// storage, without the kernel around it.
+template <typename Cell> uint64_t bench_storage(Config config) {
+    config.with_threads = false;
+    GameOfLifeKernel *kernel = new GameOfLifeKernel(config);
+    std::vector<Cell> data0((size_t)config.rows * config.cols);
+    std::vector<Cell> data1((size_t)config.rows * config.cols);
+    std::vector<Cell *> x0(config.rows);
+    std::vector<Cell *> x1(config.rows);
+    for (int i = 0; i < config.rows; i++) {
+        x0[i] = data0.data() + (size_t)i * config.cols;
+        x1[i] = data1.data() + (size_t)i * config.cols;
+        for (int j = 0; j < config.cols; j++) {
+            x0[i][j] = kernel->get_xt_at(i, j);
+        }
+    }
+    delete kernel;
+    auto t0 = std::chrono::steady_clock::now();
+    switch (config.boundary_type) {
+    case BOUNDARY_CONSTANT:
+        step_n<BOUNDARY_CONSTANT>(x0, x1, config);
+        break;
+    case BOUNDARY_MIRROR:
+        step_n<BOUNDARY_MIRROR>(x0, x1, config);
+        break;
+    default:
+        step_n<BOUNDARY_PERIODIC>(x0, x1, config);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    uint64_t hash = 0;
+    for (int i = 0; i < config.rows; i++) {
+        uint64_t row_sum = 0;
+        for (int j = 0; j < config.cols; j++) {
+            row_sum += cell_term(column_key(j), x0[i][j]);
+        }
+        hash ^= row_hash(i, row_sum);
+    }
+    print_result("templated " + std::to_string(sizeof(Cell) * 8) +
+                     " bit cells 1t",
+                 config, std::chrono::duration<double>(t1 - t0).count(), hash);
+    return hash;
+}
+
+int main(int argc, char *argv[]) {
+    // Initialize default values
+    Config config{};
+    config.rows = 2048;
+    config.cols = 2048;
+    config.n_steps = 100;
+    config.boundary_type = BOUNDARY_PERIODIC;
+    config.zoom_factor = 1;
+    config.with_threads = true;
+    config.on_cycle = CYCLE_CONTINUE;
+    config.seed = 1;
+    config.kernel_variant = KERNEL_SPECIALIZED;
+    config.density = 0.5;
+    config.sparse_density = 0;
+    config.quiet = true;
+    config.headless = false;
+    config.export_format = 0;
+    config.export_every = 1;
+    config.history_mb = 0;
+    config.n_threads = 0;
+    config.tile_h = 0;
+    config.tile_w = 0;
+    config.autotune = AUTOTUNE_OFF;
+    config.step_ahead = 0;
+    config.density_pyramid = false;
+    config.zoom_out = 1;
+    // Parse arguments
+    std::vector<std::string> args(argv + 1, argv + argc);
+    parse_arguments(args, &config);
+    if (alloc_mode) {
+        double gb = 2.0 * config.rows * config.cols * sizeof(int) / (1 << 30);
+        std::cout << "--- Grid buffers: " << std::fixed << std::setprecision(3) << gb
+                  << " GB" << std::endl;
+        // The second kernel on the same arena reuses its mapping.
+        GridArena pages(false);
+        GridArena huge(true);
+        std::vector<uint64_t> hashes;
+        hashes.push_back(bench_alloc(config, &pages, "small pages"));
+        hashes.push_back(bench_alloc(config, &huge, "huge pages"));
+        hashes.push_back(bench_alloc(config, &huge, "huge pages, reused"));
+        for (uint64_t hash : hashes) {
+            if (hash != hashes[0]) {
+                std::cout << "--- Results differ between arenas!" << std::endl;
+                return 1;
+            }
+        }
+        return 0;
+    }
+    if (!check_ahead_edits(config)) {
+        std::cout << "--- Edits made while stepping ahead were lost!"
+                  << std::endl;
+        return 1;
+    }
+    // Indirect calls per cell vs. the templated kernels, which must give
+    // the same grid.
+    std::vector<uint64_t> hashes;
+    Config generic = config;
+    generic.kernel_variant = KERNEL_GENERIC;
+    hashes.push_back(bench_kernel(generic, "kernel generic (int)"));
+    hashes.push_back(bench_kernel(config, "kernel specialized (int)"));
+    if (config.with_threads) {
+        Config single = config;
+        single.with_threads = false;
+        generic.with_threads = false;
+        hashes.push_back(bench_kernel(generic, "kernel generic (int)"));
+        hashes.push_back(bench_kernel(single, "kernel specialized (int)"));
+    }
+    // The sparse engine only handles constant and periodic boundaries.
+    if (config.boundary_type == BOUNDARY_CONSTANT ||
+        config.boundary_type == BOUNDARY_PERIODIC) {
+        Config sparse = config;
+        sparse.sparse_density = 1.0;
+        hashes.push_back(bench_kernel(sparse, "kernel sparse"));
+    }
+    // The bare loops only know the bounded domains.
+    if (config.boundary_type != BOUNDARY_UNBOUNDED) {
+        hashes.push_back(bench_storage<int>(config));
+        hashes.push_back(bench_storage<uint8_t>(config));
+    }
+    for (uint64_t hash : hashes) {
+        if (hash != hashes[0]) {
+            std::cout << "--- Results differ between kernels!" << std::endl;
+            return 1;
+        }
+    }
+    std::cout << "--- All kernels give the same result." << std::endl;
+    return 0;
+}
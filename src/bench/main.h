@@ -0,0 +1,36 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#ifndef GAMEOFLIFE_BENCH_MAIN_H
+#define GAMEOFLIFE_BENCH_MAIN_H
+
+#include "gol/GameOfLifeKernel.h"
+#include "gol/config.h"
+
+int parse_arguments(std::vector<std::string> args, Config *config);
+
+void print_result(const std::string &name, const Config &config,
+                  double seconds, uint64_t hash);
+
+uint64_t bench_kernel(Config config, const std::string &name);
+
+bool check_ahead_edits(Config config);
+
+uint64_t bench_alloc(Config config, GridArena *arena, const std::string &name);
+
+template <typename Cell> uint64_t bench_storage(Config config);
+
+int main(int argc, char *argv[]);
+
+#endif
@@ -0,0 +1,111 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+// Overhead of the C interface: stepping one generation per call against
+// many generations per call, and the cost of the accessors.
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "gol/gol_c.h"
+
+// Keeps the accessor loops from being optimized away.
+static volatile long sink;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int count_generation(gol_kernel *kernel, int64_t generation,
+                            void *user_data) {
+    (void)kernel;
+    (void)generation;
+    (*(long *)user_data)++;
+    return 0;
+}
+
+static gol_kernel *create(int size) {
+    gol_config config = gol_config_default();
+    config.rows = size;
+    config.cols = size;
+    config.seed = 1;
+    config.with_threads = 0;
+    config.sparse_density = 0;
+    gol_kernel *kernel = gol_create(&config);
+    if (kernel == NULL) {
+        fprintf(stderr, "gol_create: %s\n", gol_last_error());
+        exit(1);
+    }
+    return kernel;
+}
+
+int main(int argc, char **argv) {
+    int size = argc > 1 ? atoi(argv[1]) : 32;
+    int n_steps = argc > 2 ? atoi(argv[2]) : 100000;
+    gol_stats stats;
+
+    gol_kernel *kernel = create(size);
+    double t0 = now_ns();
+    for (int i = 0; i < n_steps; i++)
+        gol_step(kernel, 1);
+    double single = (now_ns() - t0) / n_steps;
+    gol_get_stats(kernel, &stats);
+    uint64_t hash = stats.hash;
+    gol_destroy(kernel);
+
+    kernel = create(size);
+    t0 = now_ns();
+    gol_step(kernel, n_steps);
+    double batched = (now_ns() - t0) / n_steps;
+    gol_get_stats(kernel, &stats);
+    if (stats.hash != hash) {
+        fprintf(stderr, "hash mismatch between step(1) and step(N)\n");
+        return 1;
+    }
+
+    long count = 0;
+    gol_set_callback(kernel, count_generation, &count);
+    t0 = now_ns();
+    gol_step(kernel, n_steps);
+    double callback = (now_ns() - t0) / n_steps;
+
+    int rows, cols, stride;
+    long sum = 0;
+    t0 = now_ns();
+    for (int i = 0; i < n_steps; i++)
+        sum += gol_get_buffer(kernel, &rows, &cols, &stride)[i % size];
+    double buffer = (now_ns() - t0) / n_steps;
+
+    t0 = now_ns();
+    for (int i = 0; i < n_steps; i++) {
+        gol_get_stats(kernel, &stats);
+        sum += stats.population;
+    }
+    double get_stats = (now_ns() - t0) / n_steps;
+    sink = sum;
+    gol_destroy(kernel);
+
+    printf("--- %dx%d, %d steps\n", size, size, n_steps);
+    printf("step(1) x N     : %10.1f ns/generation\n", single);
+    printf("step(N)         : %10.1f ns/generation\n", batched);
+    printf("step(N) callback: %10.1f ns/generation (%ld calls)\n", callback,
+           count);
+    printf("per-call cost   : %10.1f ns\n", single - batched);
+    printf("get_buffer      : %10.1f ns/call\n", buffer);
+    printf("get_stats       : %10.1f ns/call\n", get_stats);
+    return 0;
+}
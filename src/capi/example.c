@@ -0,0 +1,78 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+// Minimal C consumer of the shared library: steps a grid with a callback
+// and reads the cells through the borrowed buffer.
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "gol/gol_c.h"
+
+static int on_generation(gol_kernel *kernel, int64_t generation,
+                         void *user_data) {
+    gol_stats stats;
+    gol_get_stats(kernel, &stats);
+    if (generation % 100 == 0)
+        printf("generation %5lld: population %lld\n", (long long)generation,
+               (long long)stats.population);
+    // Stop as soon as the grid settles in a cycle.
+    return stats.period > 0;
+}
+
+int main(int argc, char **argv) {
+    if (gol_api_version() != GOL_API_VERSION) {
+        fprintf(stderr, "library has API version %d, expected %d\n",
+                gol_api_version(), GOL_API_VERSION);
+        return 1;
+    }
+    gol_config config = gol_config_default();
+    config.rows = 64;
+    config.cols = 64;
+    config.seed = 1;
+    config.with_threads = 0;
+    int n_steps = argc > 1 ? atoi(argv[1]) : 1000;
+
+    gol_kernel *kernel = gol_create(&config);
+    if (kernel == NULL) {
+        fprintf(stderr, "gol_create: %s\n", gol_last_error());
+        return 1;
+    }
+    gol_set_callback(kernel, on_generation, NULL);
+    int n = gol_step(kernel, n_steps);
+    if (n < 0) {
+        fprintf(stderr, "gol_step: %s\n", gol_last_error());
+        gol_destroy(kernel);
+        return 1;
+    }
+
+    int rows, cols, stride;
+    const int *cells = gol_get_buffer(kernel, &rows, &cols, &stride);
+    long population = 0;
+    for (int r = 0; r < rows; r++)
+        for (int c = 0; c < cols; c++)
+            population += cells[r * stride + c];
+    for (int r = 0; r < 16; r++) {
+        for (int c = 0; c < 32; c++)
+            putchar(cells[r * stride + c] ? '#' : '.');
+        putchar('\n');
+    }
+    gol_stats stats;
+    gol_get_stats(kernel, &stats);
+    printf("steps: %d, generation: %lld, population: %ld, period: %d, "
+           "hash: %016llx\n",
+           n, (long long)stats.generation, population, stats.period,
+           (unsigned long long)stats.hash);
+    gol_destroy(kernel);
+    return 0;
+}
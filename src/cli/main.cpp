@@ -12,9 +12,12 @@
 //   See the License for the specific language governing permissions and
 //   limitations under the License.
 //
+#include <algorithm>
 #include <chrono>
 #include <cstdio>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string>
@@ -28,6 +31,18 @@
 #endif
 
 #include "main.h"
+#include "gol/Profiler.h"
+
+// Output file for the Chrome trace of the run, if requested.
+static std::string trace_file;
+static bool trace_counters = false;
+// Output directory or encoder command for the exported frames.
+static std::string export_output;
+// Part of the terminal that shows the domain.
+static int view_rows = 0;
+static int view_cols = 0;
+// Shades of the overview, from empty to fully alive.
+static const char OVERVIEW_SHADES[] = " .:-=+*#%@";
 
 void get_terminal_size(Config *config) {
     int arg_rows = config->rows;
@@ -66,6 +81,34 @@ void get_terminal_size(Config *config) {
     if (config->cols <= 0) {
         config->cols = 80;
     }
+    view_rows = config->rows;
+    view_cols = config->cols;
+    // With the overview, a larger domain is shown downsampled.
+    if (config->density_pyramid) {
+        config->rows = std::max(config->rows, arg_rows);
+        config->cols = std::max(config->cols, arg_cols);
+    }
+}
+
+std::string overview_to_string(const DensityPyramid *pyramid) {
+    std::vector<float> density((size_t)view_rows * view_cols);
+    pyramid->sample(view_rows, view_cols, density.data());
+    const int n_shades = sizeof(OVERVIEW_SHADES) - 1;
+    std::stringstream ss;
+    for (int i = 0; i < view_rows; i++) {
+        for (int j = 0; j < view_cols; j++) {
+            // Any live cell shows up. Blocks are rarely more than half
+            // alive, so half is the last shade.
+            float d = density[(size_t)i * view_cols + j];
+            int shade = 0;
+            if (d > 0)
+                shade = std::min(n_shades - 1,
+                                 1 + (int)(2 * d * (n_shades - 1)));
+            ss << OVERVIEW_SHADES[shade];
+        }
+        ss << std::endl;
+    }
+    return ss.str();
 }
 
 int parse_arguments(std::vector<std::string> args, Config *config) {
@@ -92,7 +135,67 @@ int parse_arguments(std::vector<std::string> args, Config *config) {
                 << "   --steps <number>      : number of steps, default = 1000."
                 << std::endl;
             std::cout << "   --bt <number>         : boundary type: 0=const, "
-                         "1=periodic, 2=mirror, default=1."
+                         "1=periodic, 2=mirror, 3=unbounded, default=1."
+                      << std::endl;
+            std::cout << "   --on-cycle <number>   : action when the grid has "
+                         "settled in a cycle or still life: 0=continue, "
+                         "1=stop, 2=fast-forward to the last step, default=0."
+                      << std::endl;
+            std::cout << "   --ensemble <number>   : run a number of independent "
+                         "universes (default 64x64) without display and "
+                         "report their statistics."
+                      << std::endl;
+            std::cout << "   --seed <number>       : seed of the initial "
+                         "conditions, 0=random; in ensemble mode the seed of "
+                         "the first universe, default = 0."
+                      << std::endl;
+            std::cout << "   --kernel <number>     : kernel variant: 0=generic, "
+                         "1=specialized, default=1."
+                      << std::endl;
+            std::cout << "   --density <number>    : fraction of live cells in "
+                         "the initial conditions, default = 0.5."
+                      << std::endl;
+            std::cout << "   --sparse <number>     : density below which only "
+                         "the live cells are stepped, 0=never, default = 0.01."
+                      << std::endl;
+            std::cout << "   --headless            : don't print the domain and "
+                         "don't wait between steps."
+                      << std::endl;
+            std::cout << "   --export <dir>        : write the generations as "
+                         "images to a directory."
+                      << std::endl;
+            std::cout << "   --export-pipe <cmd>   : write the generations as "
+                         "raw RGB frames to the stdin of an encoder command."
+                      << std::endl;
+            std::cout << "   --export-format <n>   : image format: 0=ppm, "
+                         "1=png, default=1."
+                      << std::endl;
+            std::cout << "   --export-every <n>    : export every n-th "
+                         "generation, default = 1."
+                      << std::endl;
+            std::cout << "   --zoom <number>       : zoom factor of the "
+                         "exported frames, default = 1."
+                      << std::endl;
+            std::cout << "   --overview            : allow a domain larger than "
+                         "the terminal and show its density."
+                      << std::endl;
+            std::cout << "   --trace <file>        : write per-phase timings as "
+                         "Chrome trace JSON (needs -DGOL_PROFILING=ON)."
+                      << std::endl;
+            std::cout << "   --counters            : add cycles and cache misses "
+                         "to the trace (Linux)."
+                      << std::endl;
+            std::cout << "   --threads <number>    : number of threads, 0=one "
+                         "per cpu core, default = 0."
+                      << std::endl;
+            std::cout << "   --tile <h>x<w>        : tile size of the "
+                         "specialized kernel, default = 64x64."
+                      << std::endl;
+            std::cout << "   --autotune            : pick threads, tile size and "
+                         "kernel by timing them, cached per host and size."
+                      << std::endl;
+            std::cout << "   --retune              : like --autotune, but "
+                         "ignore the cache."
                       << std::endl;
             std::cout << "   --without-threads     : compute single threaded."
                       << std::endl;
@@ -109,6 +212,50 @@ int parse_arguments(std::vector<std::string> args, Config *config) {
             config->n_steps = stoi(*++i);
         } else if (*i == "--bt") {
             config->boundary_type = stoi(*++i);
+        } else if (*i == "--on-cycle") {
+            config->on_cycle = stoi(*++i);
+        } else if (*i == "--ensemble") {
+            config->ensemble_size = stoi(*++i);
+        } else if (*i == "--seed") {
+            config->seed = stoul(*++i);
+        } else if (*i == "--kernel") {
+            config->kernel_variant = stoi(*++i);
+        } else if (*i == "--density") {
+            config->density = stof(*++i);
+        } else if (*i == "--sparse") {
+            config->sparse_density = stof(*++i);
+        } else if (*i == "--headless") {
+            config->headless = true;
+        } else if (*i == "--export") {
+            export_output = *++i;
+        } else if (*i == "--export-pipe") {
+            export_output = *++i;
+            config->export_format = EXPORT_RAW;
+        } else if (*i == "--export-format") {
+            config->export_format = stoi(*++i);
+        } else if (*i == "--export-every") {
+            config->export_every = stoi(*++i);
+        } else if (*i == "--zoom") {
+            config->zoom_factor = stoi(*++i);
+        } else if (*i == "--overview") {
+            config->density_pyramid = true;
+        } else if (*i == "--trace") {
+            trace_file = *++i;
+        } else if (*i == "--counters") {
+            trace_counters = true;
+        } else if (*i == "--threads") {
+            config->n_threads = stoi(*++i);
+        } else if (*i == "--tile") {
+            std::string tile = *++i;
+            size_t x = tile.find('x');
+            config->tile_h = stoi(tile.substr(0, x));
+            config->tile_w = (x == std::string::npos)
+                                 ? config->tile_h
+                                 : stoi(tile.substr(x + 1));
+        } else if (*i == "--autotune") {
+            config->autotune = AUTOTUNE_CACHED;
+        } else if (*i == "--retune") {
+            config->autotune = AUTOTUNE_FORCE;
         } else if (*i == "--without-threads") {
             config->with_threads = false;
         } else if (*i == "--with-threads") {
@@ -118,6 +265,59 @@ int parse_arguments(std::vector<std::string> args, Config *config) {
     return 0;
 }
 
+void print_extent(GameOfLifeKernel *kernel, std::ostream &out) {
+    Extent extent = kernel->get_extent();
+    if (extent.min_row > extent.max_row)
+        return;
+    out << "[ extent: " << extent.min_col << "," << extent.min_row
+        << " - " << extent.max_col << "," << extent.max_row << " ]-";
+}
+
+void write_trace() {
+#ifdef GOL_PROFILING
+    if (trace_file.empty())
+        return;
+    if (Profiler::write_chrome_trace(trace_file)) {
+        std::cout << "--- Trace written to " << trace_file << std::endl;
+    } else {
+        std::cout << "--- Could not write trace to " << trace_file << std::endl;
+    }
+#endif
+}
+
+int run_ensemble(Config config) {
+    // The ensemble is not displayed, so the terminal size does not apply.
+    if (config.rows <= 1)
+        config.rows = 64;
+    if (config.cols <= 1)
+        config.cols = 64;
+    GameOfLifeEnsemble *ensemble =
+        new GameOfLifeEnsemble(config, config.ensemble_size, config.seed);
+    auto t0 = std::chrono::steady_clock::now();
+    ensemble->run(config.n_steps);
+    auto t1 = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(t1 - t0).count();
+    // Print one line per universe.
+    std::cout << std::setw(10) << "seed" << std::setw(12) << "population"
+              << std::setw(8) << "period" << std::setw(12) << "stabilized"
+              << std::endl;
+    int n_settled = 0;
+    for (int u = 0; u < ensemble->get_n_universes(); u++) {
+        UniverseStats stats = ensemble->get_stats(u);
+        std::cout << std::setw(10) << stats.seed << std::setw(12)
+                  << stats.population << std::setw(8) << stats.period
+                  << std::setw(12) << stats.stabilized_at << std::endl;
+        if (stats.period > 0)
+            n_settled++;
+    }
+    std::cout << "[ universes: " << ensemble->get_n_universes() << " ]-";
+    std::cout << "[ settled: " << n_settled << " ]-";
+    std::cout << "[ steps: " << ensemble->get_generation() << " ]-";
+    std::cout << "[ time: " << seconds << " s ]" << std::endl;
+    delete ensemble;
+    return 0;
+}
+
 int main(int argc, char **argv) {
     // Initialize default values
     Config config{};
@@ -130,38 +330,146 @@ int main(int argc, char **argv) {
     config.zoom_factor = 1;
     config.with_threads = true;
     config.mode_fullscreen = false;
+    config.on_cycle = CYCLE_CONTINUE;
+    config.ensemble_size = 0;
+    config.seed = 0;
+    config.kernel_variant = KERNEL_SPECIALIZED;
+    config.density = 0.5;
+    config.sparse_density = 0.01;
+    config.quiet = false;
+    config.headless = false;
+    config.export_format = EXPORT_PNG;
+    config.export_every = 1;
+    config.history_mb = 0;
+    config.n_threads = 0;
+    config.tile_h = 0;
+    config.tile_w = 0;
+    config.autotune = AUTOTUNE_OFF;
+    config.step_ahead = 0;
+    config.density_pyramid = false;
+    config.zoom_out = 1;
     // Parse arguments
     std::vector<std::string> args(argv + 1, argv + argc);
     parse_arguments(args, &config);
-    // Get the default terminal size.
-    std::cout << config.cols << std::endl;
-    get_terminal_size(&config);
-    std::cout << config.cols << std::endl;
+    if (!trace_file.empty()) {
+#ifdef GOL_PROFILING
+        Profiler::enable(trace_counters);
+#else
+        std::cout << "--- Built without GOL_PROFILING, --trace is ignored."
+                  << std::endl;
+#endif
+    }
+    if (config.ensemble_size > 0) {
+        int status = run_ensemble(config);
+        write_trace();
+        exit(status);
+    }
+    if (config.headless) {
+        // Without a terminal, use the default size of the GUI.
+        if (config.rows <= 1)
+            config.rows = 240;
+        if (config.cols <= 1)
+            config.cols = 320;
+    } else {
+        // Get the default terminal size.
+        get_terminal_size(&config);
+    }
+    if (config.autotune != AUTOTUNE_OFF) {
+        AutoTuner tuner;
+        TuneResult tuned =
+            tuner.tune(&config, config.autotune == AUTOTUNE_FORCE);
+        std::cout << "--- Tuned: " << AutoTuner::to_string(tuned) << std::endl;
+    }
     // Init the kernel.
     GameOfLifeKernel *kernel = new GameOfLifeKernel(config);
     int n_threads = kernel->get_n_threads();
     int n_cpus = kernel->get_n_cpus();
+    FrameExporter *exporter = nullptr;
+    if (!export_output.empty()) {
+        exporter = new FrameExporter(config, config.export_format,
+                                     export_output);
+    }
+    if (config.export_every < 1)
+        config.export_every = 1;
     // Allow the user to read the domain slicing in the terminal window.
-    std::this_thread::sleep_for(std::chrono::seconds(2));
+    if (!config.headless)
+        std::this_thread::sleep_for(std::chrono::seconds(2));
+    auto t0 = std::chrono::steady_clock::now();
     // Game loop.
     for (auto i = 0; i < config.n_steps; i++) {
-        // VT100 compatible escape codes to clear the screen.
-        std::cout << "\033[H\033[J";
-        // Print the current state of the domain.
-        /* kernel->printDomain(); */
-        std::cout << kernel->to_string();
-        // Print a status line.
-        std::cout << "[ cpus: " << n_cpus << " ]-";
-        std::cout << "[ threads: " << n_threads << " ]-";
-        std::cout << "[ width: " << config.cols << " ]-";
-        std::cout << "[ height: " << config.rows << " ]-";
-        std::cout << "[ step: " << i << " / " << config.n_steps - 1 << " ] ";
-        std::flush(std::cout);
-        // Go one timestep forward.
-        kernel->timestep();
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        std::stringstream screen;
+        if (!config.headless) {
+            // VT100 compatible escape codes to clear the screen.
+            screen << "\033[H\033[J";
+            // The current state of the domain, or its density if it does
+            // not fit.
+            if (config.density_pyramid &&
+                (config.rows > view_rows || config.cols > view_cols))
+                screen << overview_to_string(kernel->get_pyramid());
+            else
+                screen << kernel->to_string();
+            // A status line.
+            screen << "[ cpus: " << n_cpus << " ]-";
+            screen << "[ threads: " << n_threads << " ]-";
+            screen << "[ width: " << config.cols << " ]-";
+            screen << "[ height: " << config.rows << " ]-";
+            screen << "[ step: " << i << " / " << config.n_steps - 1 << " ] ";
+            if (kernel->get_period() > 0)
+                screen << "-[ period: " << kernel->get_period() << " ] ";
+            if (config.boundary_type == BOUNDARY_UNBOUNDED)
+                print_extent(kernel, screen);
+        }
+        if (exporter != nullptr && i % config.export_every == 0)
+            exporter->push(kernel->get_xt(), i);
+        if (i == config.n_steps - 1) {
+            std::cout << screen.str();
+            std::flush(std::cout);
+            break;
+        }
+        // Go one timestep forward. With a display, the next generation is
+        // computed while the current one is printed.
+        if (config.headless) {
+            kernel->timestep();
+        } else {
+            std::future<long> stepping = kernel->step_async();
+            std::cout << screen.str();
+            std::flush(std::cout);
+            stepping.get();
+        }
+        if (kernel->get_period() > 0 && config.on_cycle == CYCLE_STOP)
+            break;
+        if (kernel->get_period() > 0 &&
+            config.on_cycle == CYCLE_FAST_FORWARD) {
+            // The state at the last step equals the state a whole number of
+            // periods earlier, so only the remainder has to be computed.
+            int remaining = config.n_steps - 1 - (i + 1);
+            for (int k = 0; k < remaining % kernel->get_period(); k++) {
+                kernel->timestep();
+            }
+            i = config.n_steps - 2;
+        }
+        if (!config.headless)
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    std::cout << std::endl;
+    if (exporter != nullptr) {
+        exporter->finish();
+    }
+    if (config.headless) {
+        auto t1 = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(t1 - t0).count();
+        std::cout << "[ steps: " << kernel->get_generation() << " ]-";
+        if (exporter != nullptr)
+            std::cout << "[ frames: " << exporter->get_n_frames() << " ]-";
+        std::cout << "[ population: " << kernel->get_population() << " ]-";
+        std::cout << "[ period: " << kernel->get_period() << " ]-";
+        if (config.boundary_type == BOUNDARY_UNBOUNDED)
+            print_extent(kernel, std::cout);
+        std::cout << "[ time: " << seconds << " s ]" << std::endl;
     }
     // Cleanup
+    delete exporter;
     delete kernel;
+    write_trace();
     exit(0);
 }
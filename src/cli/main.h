@@ -15,11 +15,22 @@
 #ifndef GAMEOFLIFE_CLI_MAIN_H
 #define GAMEOFLIFE_CLI_MAIN_H
 
+#include "gol/AutoTuner.h"
+#include "gol/FrameExporter.h"
+#include "gol/GameOfLifeEnsemble.h"
 #include "gol/GameOfLifeKernel.h"
 #include "gol/config.h"
 
 void get_terminal_size(Config *config);
 
+int run_ensemble(Config config);
+
+void write_trace();
+
+void print_extent(GameOfLifeKernel *kernel, std::ostream &out);
+
+std::string overview_to_string(const DensityPyramid *pyramid);
+
 int parse_arguments(std::vector<std::string> args, Config *config);
 
 int main(int argc, char *argv[]);
@@ -12,9 +12,13 @@
 //   See the License for the specific language governing permissions and
 //   limitations under the License.
 //
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
 #include <ostream>
 #include "app.h"
+#include "gol/AutoTuner.h"
+#include "gol/Patterns.h"
 
 App::App(Config config_) : config(config_) {
     steps_per_sec = 10;
@@ -24,11 +28,55 @@ App::App(Config config_) : config(config_) {
     fps = 0;
     frame_count = 0;
     running = false;
+    paused = false;
+    scrubbing = false;
+    stamp_pattern = -1;
+    paint_value = -1;
+    paint_row = -1;
+    paint_col = -1;
+    ahead = nullptr;
     init_video();
+    // The domain size is known once the window is open.
+    if (config.autotune != AUTOTUNE_OFF) {
+        AutoTuner tuner;
+        TuneResult tuned =
+            tuner.tune(&config, config.autotune == AUTOTUNE_FORCE);
+        std::cout << "--- Tuned: " << AutoTuner::to_string(tuned) << std::endl;
+    }
+    if (config.zoom_out > 1 && config.step_ahead > 0) {
+        // The pyramid belongs to the kernel, which is busy stepping ahead.
+        std::cout << "--- Step-ahead is not used with --zoom-out."
+                  << std::endl;
+        config.step_ahead = 0;
+    }
+    if (config.boundary_type == BOUNDARY_UNBOUNDED && config.step_ahead > 0) {
+        // Pausing rewinds to a snapshot of the viewport, which would drop
+        // the universe around it.
+        std::cout << "--- Step-ahead is not used for unbounded domains."
+                  << std::endl;
+        config.step_ahead = 0;
+    }
+    if (config.boundary_type == BOUNDARY_UNBOUNDED && config.history_mb > 0) {
+        // A history generation only holds the viewport, restoring it would
+        // drop the universe around it.
+        std::cout << "--- The history is not kept for unbounded domains."
+                  << std::endl;
+        config.history_mb = 0;
+    }
     kernel = new GameOfLifeKernel(config);
+    history = nullptr;
+    if (config.history_mb > 0) {
+        history = new HistoryBuffer(config.rows, config.cols,
+                                    (size_t)config.history_mb << 20);
+        history_cells.resize((size_t)config.rows * config.cols);
+        for (int i = 0; i < config.rows; i++)
+            history_rows.push_back(&history_cells[(size_t)i * config.cols]);
+    }
 }
 
 App::~App() {
+    delete ahead;
+    delete history;
     delete kernel;
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
@@ -50,8 +98,10 @@ void App::init_video() {
         config.display_w = mode.w / 2;
         config.display_h = mode.h / 2;
     }
-    config.rows = (int)(config.display_h / config.zoom_factor);
-    config.cols = (int)(config.display_w / config.zoom_factor);
+    overview_rows = (int)(config.display_h / config.zoom_factor);
+    overview_cols = (int)(config.display_w / config.zoom_factor);
+    config.rows = overview_rows * std::max(1, config.zoom_out);
+    config.cols = overview_cols * std::max(1, config.zoom_out);
     window = SDL_CreateWindow("Game of Life", 0, 0, config.display_w, config.display_h, 0);
     SDL_SetWindowPosition(window, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED);
     renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
@@ -60,15 +110,95 @@ void App::init_video() {
         update_window_size();
     }
     SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "nearest");
-    texture =
-        SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
-                          SDL_TEXTUREACCESS_TARGET, config.cols, config.rows);
+    if (config.zoom_out > 1) {
+        overview_density.resize((size_t)overview_rows * overview_cols);
+        overview_pixels.resize((size_t)overview_rows * overview_cols);
+        texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+                                    SDL_TEXTUREACCESS_STREAMING, overview_cols,
+                                    overview_rows);
+    } else {
+        texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+                                    SDL_TEXTUREACCESS_TARGET, config.cols,
+                                    config.rows);
+    }
 }
 
 void App::update() {
-    kernel->timestep();
+    if (!paused)
+        step_forward();
     update_window_size();
     update_events();
+    // Show edits right away, also while paused. The history continues from
+    // the edited generation. While stepping ahead, the stepping thread
+    // applies them with the next generation it computes.
+    if (ahead == nullptr && kernel->apply_edits() > 0 && history != nullptr)
+        history->push(kernel->get_xt(), kernel->get_generation());
+}
+
+void App::step_forward() {
+    // Generations that are still in the history are replayed, not
+    // recomputed.
+    long next = get_shown_generation() + 1;
+    if (history != nullptr && next <= history->get_last_generation()) {
+        seek(next);
+        return;
+    }
+    if (config.step_ahead > 0 && !paused) {
+        if (ahead == nullptr) {
+            ahead = new StepAhead(kernel, config.step_ahead, config.n_steps);
+            // The first snapshot is the generation on screen.
+            shown = ahead->next();
+        }
+        std::shared_ptr<const GridSnapshot> snapshot = ahead->next();
+        if (snapshot == nullptr)
+            return;
+        shown = snapshot;
+        if (history != nullptr)
+            history->push(shown->get_xt(), shown->get_generation());
+        return;
+    }
+    kernel->timestep();
+    if (history != nullptr)
+        history->push(kernel->get_xt(), kernel->get_generation());
+}
+
+void App::step_backward() {
+    seek(get_shown_generation() - 1);
+}
+
+void App::seek(long generation) {
+    stop_ahead();
+    if (history == nullptr ||
+        !history->restore(generation, history_rows.data()))
+        return;
+    kernel->set_state(history_rows.data(), generation);
+}
+
+void App::stop_ahead() {
+    if (ahead == nullptr)
+        return;
+    // Take the kernel back from the generations computed ahead to the one
+    // on screen, keeping the cells painted meanwhile.
+    if (shown != nullptr)
+        ahead->rewind(*shown);
+    delete ahead;
+    ahead = nullptr;
+    shown.reset();
+}
+
+long App::get_shown_generation() const {
+    if (shown != nullptr)
+        return shown->get_generation();
+    return kernel->get_generation();
+}
+
+void App::seek_to_x(int x) {
+    if (history == nullptr || config.display_w <= 0)
+        return;
+    long generation = (long)x * config.n_steps / config.display_w;
+    generation = std::max(generation, history->get_first_generation());
+    generation = std::min(generation, history->get_last_generation());
+    seek(generation);
 }
 
 void App::update_window_size() {
@@ -86,25 +216,156 @@ void App::update_events() {
             running = false;
         if (keystates[SDL_SCANCODE_Q])
             running = false;
+        if (event.type == SDL_KEYDOWN) {
+            switch (event.key.keysym.sym) {
+            case SDLK_SPACE:
+                paused = !paused;
+                if (paused)
+                    stop_ahead();
+                break;
+            case SDLK_LEFT:
+                paused = true;
+                step_backward();
+                break;
+            case SDLK_RIGHT:
+                paused = true;
+                stop_ahead();
+                step_forward();
+                break;
+            case SDLK_0:
+                stamp_pattern = -1;
+                break;
+            case SDLK_1:
+                stamp_pattern = 0;
+                break;
+            case SDLK_2:
+                stamp_pattern = 1;
+                break;
+            case SDLK_3:
+                stamp_pattern = 2;
+                break;
+            case SDLK_4:
+                stamp_pattern = 3;
+                break;
+            }
+        }
+        if (event.type == SDL_MOUSEBUTTONDOWN) {
+            if (history != nullptr &&
+                event.button.y >= config.display_h - SCRUB_BAR_HEIGHT) {
+                // Clicking or dragging in the scrub bar jumps to a
+                // generation.
+                if (event.button.button == SDL_BUTTON_LEFT) {
+                    scrubbing = true;
+                    paused = true;
+                    seek_to_x(event.button.x);
+                }
+            } else if (stamp_pattern >= 0 &&
+                       event.button.button == SDL_BUTTON_LEFT) {
+                stamp(event.button.x, event.button.y);
+            } else if (event.button.button == SDL_BUTTON_LEFT ||
+                       event.button.button == SDL_BUTTON_RIGHT) {
+                // Left paints live cells, right erases them.
+                paint_value = (event.button.button == SDL_BUTTON_LEFT);
+                paint(event.button.x, event.button.y);
+            }
+        }
+        if (event.type == SDL_MOUSEMOTION && scrubbing)
+            seek_to_x(event.motion.x);
+        if (event.type == SDL_MOUSEMOTION && paint_value >= 0)
+            paint(event.motion.x, event.motion.y);
+        if (event.type == SDL_MOUSEBUTTONUP) {
+            scrubbing = false;
+            paint_value = -1;
+            paint_row = -1;
+        }
+    }
+}
+
+void App::window_to_cell(int x, int y, int *row, int *col) {
+    *row = std::min(config.rows - 1,
+                    std::max(0, (int)((long)y * config.rows /
+                                      std::max(1, config.display_h))));
+    *col = std::min(config.cols - 1,
+                    std::max(0, (int)((long)x * config.cols /
+                                      std::max(1, config.display_w))));
+}
+
+void App::paint(int x, int y) {
+    int row, col;
+    window_to_cell(x, y, &row, &col);
+    if (paint_row < 0) {
+        paint_row = row;
+        paint_col = col;
+    }
+    // Also set the cells between the previous and the current mouse
+    // position, so a fast drag leaves no gaps.
+    int n = std::max(std::abs(row - paint_row), std::abs(col - paint_col));
+    for (int k = 0; k <= n; k++) {
+        int r = paint_row + (n > 0 ? (row - paint_row) * k / n : 0);
+        int c = paint_col + (n > 0 ? (col - paint_col) * k / n : 0);
+        kernel->edit(r, c, paint_value);
+    }
+    paint_row = row;
+    paint_col = col;
+}
+
+void App::stamp(int x, int y) {
+    int row, col;
+    window_to_cell(x, y, &row, &col);
+    // Center the pattern on the mouse position.
+    const char *cells = PATTERNS[stamp_pattern].cells;
+    int height = 1;
+    int width = 0;
+    for (int k = 0, w = 0; cells[k] != '\0'; k++) {
+        if (cells[k] == '\n') {
+            height++;
+            w = 0;
+        } else {
+            width = std::max(width, ++w);
+        }
+    }
+    int r = row - height / 2;
+    int c = col - width / 2;
+    for (int k = 0; cells[k] != '\0'; k++) {
+        if (cells[k] == '\n') {
+            r++;
+            c = col - width / 2;
+            continue;
+        }
+        int er = r;
+        int ec = c++;
+        if (config.boundary_type == BOUNDARY_PERIODIC) {
+            er = (er % config.rows + config.rows) % config.rows;
+            ec = (ec % config.cols + config.cols) % config.cols;
+        }
+        kernel->edit(er, ec, cells[k] == 'O');
     }
 }
 
 void App::draw() {
     draw_cells();
+    draw_scrub_bar();
     draw_progress_bar();
     SDL_RenderPresent(renderer);
 }
 
 void App::draw_cells() {
+    if (config.zoom_out > 1) {
+        draw_overview();
+        return;
+    }
     SDL_SetRenderTarget(renderer, texture);
     // Clear render target.
     SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
     SDL_RenderClear(renderer);
     // Draw pixels.
     SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    // While stepping ahead the kernel is computing later generations, the
+    // window shows the snapshot of the current one.
     for (int row = 0; row < config.rows; row++) {
         for (int col = 0; col < config.cols; col++) {
-            int value = kernel->get_xt_at(row, col);
+            int value = (shown != nullptr) ? shown->get_xt_at(row, col)
+                                           : kernel->get_xt_at(row, col);
             if (value == 1)
                 SDL_RenderDrawPoint(renderer, col, row);
         }
@@ -114,6 +375,21 @@ void App::draw_cells() {
     SDL_RenderCopy(renderer, texture, NULL, NULL);
 }
 
+void App::draw_overview() {
+    // One pixel per block of zoom_out x zoom_out cells, shaded by its
+    // density, with half alive as black.
+    const DensityPyramid *pyramid = kernel->get_pyramid();
+    pyramid->sample(overview_rows, overview_cols, overview_density.data());
+    for (size_t k = 0; k < overview_pixels.size(); k++) {
+        const float d = std::min(1.0f, 2 * overview_density[k]);
+        const Uint32 v = 255 - (Uint32)(255 * d);
+        overview_pixels[k] = 0xff000000 | (v << 16) | (v << 8) | v;
+    }
+    SDL_UpdateTexture(texture, NULL, overview_pixels.data(),
+                      overview_cols * sizeof(Uint32));
+    SDL_RenderCopy(renderer, texture, NULL, NULL);
+}
+
 void App::draw_progress_bar() {
     const int y = (int)(config.display_h - 1);
     const int x0 = 0;
@@ -121,6 +397,26 @@ void App::draw_progress_bar() {
     SDL_RenderDrawLine(renderer, x0, y, x1, y);
 }
 
+void App::draw_scrub_bar() {
+    if (history == nullptr || history->get_first_generation() < 0)
+        return;
+    // The width of the window spans generations 0 - n_steps; the retained
+    // generations are shaded and the shown one is marked.
+    const float scale = (float)config.display_w / config.n_steps;
+    SDL_Rect retained;
+    retained.x = (int)(history->get_first_generation() * scale);
+    retained.y = config.display_h - SCRUB_BAR_HEIGHT;
+    retained.w = std::max(
+        1, (int)(history->get_last_generation() * scale) - retained.x);
+    retained.h = SCRUB_BAR_HEIGHT;
+    SDL_SetRenderDrawColor(renderer, 192, 192, 192, 255);
+    SDL_RenderFillRect(renderer, &retained);
+    const int x = (int)(get_shown_generation() * scale);
+    SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);
+    SDL_RenderDrawLine(renderer, x, retained.y, x, config.display_h - 1);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+}
+
 void App::tick_one_sec() {
     time = SDL_GetTicks();
     if (time >= (prev_time + 1000)) {
@@ -140,11 +436,12 @@ void App::limit_fps() {
 
 void App::run() {
     running = true;
-    for (int step = 0; step < config.n_steps; step++) {
-        if (!running)
-            break;
+    if (history != nullptr)
+        history->push(kernel->get_xt(), kernel->get_generation());
+    // While paused the window stays open, also after the last step.
+    while (running && (paused || get_shown_generation() < config.n_steps)) {
         tick_one_sec();
-        progress = (float)step / config.n_steps;
+        progress = (float)get_shown_generation() / config.n_steps;
         update();
         draw();
         limit_fps();
@@ -23,9 +23,16 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <memory>
+#include <vector>
 #include "gol/GameOfLifeKernel.h"
+#include "gol/HistoryBuffer.h"
+#include "gol/StepAhead.h"
 #include "gol/config.h"
 
+// Height in pixels of the scrub bar at the bottom of the window.
+const int SCRUB_BAR_HEIGHT = 8;
+
 class App {
   public:
     App(Config config);
@@ -46,6 +53,30 @@ class App {
     SDL_Renderer *renderer;
     SDL_Texture *texture;
     GameOfLifeKernel *kernel;
+    // Past generations for stepping back and scrubbing, nullptr if the
+    // history is disabled.
+    HistoryBuffer *history;
+    std::vector<int> history_cells;
+    std::vector<int *> history_rows;
+    // Computes generations ahead while the shown one is drawn, nullptr if
+    // step-ahead is disabled or the simulation is paused. The kernel is
+    // then ahead of the window, which shows the shown snapshot.
+    StepAhead *ahead;
+    std::shared_ptr<const GridSnapshot> shown;
+    // With Config::zoom_out, the texture has one pixel per block of cells
+    // and is filled from the density pyramid of the kernel.
+    int overview_rows;
+    int overview_cols;
+    std::vector<float> overview_density;
+    std::vector<Uint32> overview_pixels;
+    bool paused;
+    bool scrubbing;
+    // Index in PATTERNS stamped by a left click, -1 to paint instead.
+    int stamp_pattern;
+    // Value painted while a mouse button is held, -1 if not painting.
+    int paint_value;
+    int paint_row;
+    int paint_col;
 
     void init_video();
     void update();
@@ -53,7 +84,18 @@ class App {
     void update_events();
     void draw();
     void draw_cells();
+    void draw_overview();
     void draw_progress_bar();
+    void draw_scrub_bar();
+    void step_forward();
+    void step_backward();
+    void seek(long generation);
+    void stop_ahead();
+    long get_shown_generation() const;
+    void seek_to_x(int x);
+    void window_to_cell(int x, int y, int *row, int *col);
+    void paint(int x, int y);
+    void stamp(int x, int y);
 
     void tick_one_sec();
     void limit_fps();
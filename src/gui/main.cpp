@@ -34,11 +34,41 @@ int parse_arguments(std::vector<std::string> args, Config *config) {
                 << "   --steps <number>      : number of steps, default = 1000."
                 << std::endl;
             std::cout
-                << "   --bt <number>         : boundary type: 0=const, 1=periodic, 2=mirror, default=1."
+                << "   --bt <number>         : boundary type: 0=const, 1=periodic, 2=mirror, 3=unbounded, default=1."
                 << std::endl;
             std::cout
                 << "   --zoom <number>       : zoom factor, default = 1."
                 << std::endl;
+            std::cout
+                << "   --zoom-out <number>   : cells per pixel, the domain is that much larger than the window, default = 1."
+                << std::endl;
+            std::cout
+                << "   --kernel <number>     : kernel variant: 0=generic, 1=specialized, default=1."
+                << std::endl;
+            std::cout
+                << "   --density <number>    : fraction of live cells in the initial conditions, default = 0.5."
+                << std::endl;
+            std::cout
+                << "   --sparse <number>     : density below which only the live cells are stepped, 0=never, default = 0.01."
+                << std::endl;
+            std::cout
+                << "   --history <number>    : memory in MB for past generations, 0=off, default = 256."
+                << std::endl;
+            std::cout
+                << "   --threads <number>    : number of threads, 0=one per cpu core, default = 0."
+                << std::endl;
+            std::cout
+                << "   --tile <h>x<w>        : tile size of the specialized kernel, default = 64x64."
+                << std::endl;
+            std::cout
+                << "   --autotune            : pick threads, tile size and kernel by timing them, cached per host and size."
+                << std::endl;
+            std::cout
+                << "   --retune              : like --autotune, but ignore the cache."
+                << std::endl;
+            std::cout
+                << "   --ahead <number>      : generations computed ahead while drawing, 0=off, default = 0."
+                << std::endl;
             std::cout
                 << "   --without-threads     : compute single threaded."
                 << std::endl;
@@ -58,6 +88,32 @@ int parse_arguments(std::vector<std::string> args, Config *config) {
             config->boundary_type = stoi(*++i);
         } else if (*i == "--zoom") {
             config->zoom_factor = stoi(*++i);
+        } else if (*i == "--zoom-out") {
+            config->zoom_out = stoi(*++i);
+            config->density_pyramid = config->zoom_out > 1;
+        } else if (*i == "--kernel") {
+            config->kernel_variant = stoi(*++i);
+        } else if (*i == "--density") {
+            config->density = stof(*++i);
+        } else if (*i == "--sparse") {
+            config->sparse_density = stof(*++i);
+        } else if (*i == "--history") {
+            config->history_mb = stoi(*++i);
+        } else if (*i == "--threads") {
+            config->n_threads = stoi(*++i);
+        } else if (*i == "--tile") {
+            std::string tile = *++i;
+            size_t x = tile.find('x');
+            config->tile_h = stoi(tile.substr(0, x));
+            config->tile_w = (x == std::string::npos)
+                                 ? config->tile_h
+                                 : stoi(tile.substr(x + 1));
+        } else if (*i == "--autotune") {
+            config->autotune = AUTOTUNE_CACHED;
+        } else if (*i == "--retune") {
+            config->autotune = AUTOTUNE_FORCE;
+        } else if (*i == "--ahead") {
+            config->step_ahead = stoi(*++i);
         } else if (*i == "--without-threads") {
             config->with_threads = false;
         } else if (*i == "--with-threads") {
@@ -82,6 +138,24 @@ int main(int argc, char *argv[]) {
     config.zoom_factor = 1;
     config.with_threads = true;
     config.mode_fullscreen = false;
+    config.on_cycle = CYCLE_CONTINUE;
+    config.ensemble_size = 0;
+    config.seed = 0;
+    config.kernel_variant = KERNEL_SPECIALIZED;
+    config.density = 0.5;
+    config.sparse_density = 0.01;
+    config.quiet = false;
+    config.headless = false;
+    config.export_format = 0;
+    config.export_every = 1;
+    config.history_mb = 256;
+    config.n_threads = 0;
+    config.tile_h = 0;
+    config.tile_w = 0;
+    config.autotune = AUTOTUNE_OFF;
+    config.step_ahead = 0;
+    config.density_pyramid = false;
+    config.zoom_out = 1;
     // Parse arguments
     std::vector<std::string> args(argv + 1, argv + argc);
     parse_arguments(args, &config);
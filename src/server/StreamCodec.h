@@ -0,0 +1,73 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#ifndef GAMEOFLIFE_STREAMCODEC_H
+#define GAMEOFLIFE_STREAMCODEC_H
+
+#include <cstdint>
+#include <vector>
+
+#include "gol/RunLength.h"
+
+// Wire format of the frame stream, shared by the server and the client.
+// All integers are little endian.
+//
+// frame header (40 bytes):
+//   u32 magic, i32 sequence, i64 generation, i32 rows, i32 cols,
+//   i32 tile size, i32 number of tiles, i64 population of the viewport
+// followed by the tile records:
+//   i32 tile row, i32 tile col, u8 kind, u8 height, u8 width, u8 unused,
+//   u32 payload length, payload
+//
+// A tile holds one row of 64 bits per row of cells. The payload of a
+// TILE_KEY record is the tile itself, the payload of a TILE_DELTA record
+// is the XOR with the tile of the previous frame; both are run-length
+// encoded with rle_encode of gol/RunLength.h. Tiles that did not change
+// are left out of a frame.
+
+const uint32_t STREAM_MAGIC = 0x534c4f47; // "GOLS"
+const int STREAM_TILE_SIZE = 64;
+const int STREAM_FRAME_HEADER_SIZE = 40;
+const int STREAM_TILE_HEADER_SIZE = 16;
+
+enum TILE_KINDS {
+    TILE_KEY = 0,
+    TILE_DELTA = 1
+};
+
+inline void put_u32(std::vector<uint8_t> &out, uint32_t v) {
+    for (int i = 0; i < 4; i++)
+        out.push_back((v >> (8 * i)) & 0xff);
+}
+
+inline void put_u64(std::vector<uint8_t> &out, uint64_t v) {
+    for (int i = 0; i < 8; i++)
+        out.push_back((v >> (8 * i)) & 0xff);
+}
+
+inline uint32_t get_u32(const uint8_t *in) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++)
+        v |= (uint32_t)in[i] << (8 * i);
+    return v;
+}
+
+inline uint64_t get_u64(const uint8_t *in) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++)
+        v |= (uint64_t)in[i] << (8 * i);
+    return v;
+}
+
+#endif
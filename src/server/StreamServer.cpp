@@ -0,0 +1,421 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#include "StreamServer.h"
+#include "StreamCodec.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+StreamServer::StreamServer(int rows, int cols, int port, int max_queue)
+    : rows(rows), cols(cols), port(port), max_queue(std::max(1, max_queue)),
+      listen_fd(-1), stopping(false), n_dropped(0), sequence(0) {
+    wake_fds[0] = -1;
+    wake_fds[1] = -1;
+    tile_rows = (rows + STREAM_TILE_SIZE - 1) / STREAM_TILE_SIZE;
+    tile_cols = (cols + STREAM_TILE_SIZE - 1) / STREAM_TILE_SIZE;
+    int n_tiles = tile_rows * tile_cols;
+    tiles.assign((size_t)n_tiles * STREAM_TILE_SIZE, 0);
+    prev_tiles.assign((size_t)n_tiles * STREAM_TILE_SIZE, 0);
+    prev_sequence.assign(n_tiles, -1);
+    tile_population.assign(n_tiles, 0);
+}
+
+StreamServer::~StreamServer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake();
+    if (network.joinable())
+        network.join();
+    for (auto &item : clients)
+        close(item.first);
+    if (listen_fd >= 0)
+        close(listen_fd);
+    if (wake_fds[0] >= 0) {
+        close(wake_fds[0]);
+        close(wake_fds[1]);
+    }
+}
+
+bool StreamServer::start() {
+    listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        std::cerr << "socket: " << strerror(errno) << std::endl;
+        return false;
+    }
+    int one = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(listen_fd, (sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(listen_fd, 16) < 0) {
+        std::cerr << "port " << port << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    fcntl(listen_fd, F_SETFL, fcntl(listen_fd, F_GETFL) | O_NONBLOCK);
+    if (pipe(wake_fds) < 0) {
+        std::cerr << "pipe: " << strerror(errno) << std::endl;
+        return false;
+    }
+    fcntl(wake_fds[0], F_SETFL, fcntl(wake_fds[0], F_GETFL) | O_NONBLOCK);
+    fcntl(wake_fds[1], F_SETFL, fcntl(wake_fds[1], F_GETFL) | O_NONBLOCK);
+    network = std::thread(&StreamServer::run, this);
+    return true;
+}
+
+int StreamServer::tile_h(int tr) const {
+    return std::min(STREAM_TILE_SIZE, rows - tr * STREAM_TILE_SIZE);
+}
+
+int StreamServer::tile_w(int tc) const {
+    return std::min(STREAM_TILE_SIZE, cols - tc * STREAM_TILE_SIZE);
+}
+
+void StreamServer::pack_tile(int **xt, int t) {
+    int tr = t / tile_cols;
+    int tc = t % tile_cols;
+    int h = tile_h(tr);
+    int w = tile_w(tc);
+    uint64_t *tile = &tiles[(size_t)t * STREAM_TILE_SIZE];
+    long population = 0;
+    for (int r = 0; r < h; r++) {
+        const int *row = xt[tr * STREAM_TILE_SIZE + r] + tc * STREAM_TILE_SIZE;
+        uint64_t word = 0;
+        for (int c = 0; c < w; c++)
+            word |= (uint64_t)(row[c] != 0) << c;
+        tile[r] = word;
+        population += __builtin_popcountll(word);
+    }
+    for (int r = h; r < STREAM_TILE_SIZE; r++)
+        tile[r] = 0;
+    tile_population[t] = population;
+}
+
+Blob StreamServer::encode_tile(int t, int kind) const {
+    int tr = t / tile_cols;
+    int tc = t % tile_cols;
+    int h = tile_h(tr);
+    const uint64_t *tile = &tiles[(size_t)t * STREAM_TILE_SIZE];
+    const uint64_t *prev = &prev_tiles[(size_t)t * STREAM_TILE_SIZE];
+    uint8_t bytes[STREAM_TILE_SIZE * 8];
+    for (int r = 0; r < h; r++) {
+        uint64_t word = kind == TILE_DELTA ? tile[r] ^ prev[r] : tile[r];
+        for (int i = 0; i < 8; i++)
+            bytes[r * 8 + i] = (word >> (8 * i)) & 0xff;
+    }
+    auto blob = std::make_shared<std::vector<uint8_t>>();
+    blob->reserve(STREAM_TILE_HEADER_SIZE + 64);
+    put_u32(*blob, tr);
+    put_u32(*blob, tc);
+    blob->push_back(kind);
+    blob->push_back(h);
+    blob->push_back(tile_w(tc));
+    blob->push_back(0);
+    put_u32(*blob, 0);
+    rle_encode(bytes, h * 8, *blob);
+    uint32_t length = blob->size() - STREAM_TILE_HEADER_SIZE;
+    for (int i = 0; i < 4; i++)
+        (*blob)[12 + i] = (length >> (8 * i)) & 0xff;
+    return blob;
+}
+
+void StreamServer::publish(int **xt, long generation) {
+    int n_tiles = tile_rows * tile_cols;
+    // What the clients need of every tile: 1 = delta, 2 = key.
+    std::vector<uint8_t> need(n_tiles, 0);
+    std::vector<std::pair<int, int>> targets;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto &item : clients) {
+            StreamClient &client = item.second;
+            for (int tr = client.tr0; tr < client.tr1; tr++)
+                for (int tc = client.tc0; tc < client.tc1; tc++)
+                    need[tr * tile_cols + tc] |= client.needs_key ? 2 : 1;
+            targets.push_back({client.fd, client.view_version});
+        }
+    }
+    sequence++;
+    // Encode each tile once, the buffers are shared by all clients.
+    std::vector<Blob> keys(n_tiles);
+    std::vector<Blob> deltas(n_tiles);
+    for (int t = 0; t < n_tiles; t++) {
+        if (need[t] == 0) {
+            prev_sequence[t] = -1;
+            continue;
+        }
+        pack_tile(xt, t);
+        if (need[t] & 2)
+            keys[t] = encode_tile(t, TILE_KEY);
+        if (need[t] & 1) {
+            size_t offset = (size_t)t * STREAM_TILE_SIZE;
+            if (prev_sequence[t] != sequence - 1) {
+                // Not sent in the previous frame, so there is no base for
+                // a delta.
+                deltas[t] = keys[t] ? keys[t] : encode_tile(t, TILE_KEY);
+            } else if (!std::equal(&tiles[offset],
+                                   &tiles[offset] + STREAM_TILE_SIZE,
+                                   &prev_tiles[offset])) {
+                deltas[t] = encode_tile(t, TILE_DELTA);
+            }
+        }
+        size_t offset = (size_t)t * STREAM_TILE_SIZE;
+        std::copy(&tiles[offset], &tiles[offset] + STREAM_TILE_SIZE,
+                  &prev_tiles[offset]);
+        prev_sequence[t] = sequence;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto &target : targets) {
+            auto it = clients.find(target.first);
+            if (it == clients.end() ||
+                it->second.view_version != target.second)
+                continue;
+            StreamClient &client = it->second;
+            if (client.queue.size() >= max_queue) {
+                // Never wait for a slow client. It misses this frame, so
+                // the next one has to be a key frame.
+                client.n_dropped++;
+                n_dropped++;
+                client.needs_key = true;
+                continue;
+            }
+            StreamFrame frame;
+            frame.blobs.push_back(nullptr);
+            long population = 0;
+            for (int tr = client.tr0; tr < client.tr1; tr++) {
+                for (int tc = client.tc0; tc < client.tc1; tc++) {
+                    int t = tr * tile_cols + tc;
+                    const Blob &blob =
+                        client.needs_key ? keys[t] : deltas[t];
+                    if (blob)
+                        frame.blobs.push_back(blob);
+                    population += tile_population[t];
+                }
+            }
+            auto header = std::make_shared<std::vector<uint8_t>>();
+            header->reserve(STREAM_FRAME_HEADER_SIZE);
+            put_u32(*header, STREAM_MAGIC);
+            put_u32(*header, sequence);
+            put_u64(*header, generation);
+            put_u32(*header, rows);
+            put_u32(*header, cols);
+            put_u32(*header, STREAM_TILE_SIZE);
+            put_u32(*header, frame.blobs.size() - 1);
+            put_u64(*header, population);
+            frame.blobs[0] = header;
+            client.queue.push_back(std::move(frame));
+            client.needs_key = false;
+        }
+    }
+    wake();
+}
+
+void StreamServer::wake() {
+    if (wake_fds[1] >= 0) {
+        char c = 0;
+        if (write(wake_fds[1], &c, 1) < 0) {
+            // The pipe is full, so the network thread wakes up anyway.
+        }
+    }
+}
+
+void StreamServer::run() {
+    std::vector<pollfd> fds;
+    while (true) {
+        fds.clear();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping)
+                break;
+            fds.push_back({listen_fd, POLLIN, 0});
+            fds.push_back({wake_fds[0], POLLIN, 0});
+            for (auto &item : clients) {
+                short events = POLLIN;
+                if (!item.second.queue.empty())
+                    events |= POLLOUT;
+                fds.push_back({item.first, events, 0});
+            }
+        }
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            std::cerr << "poll: " << strerror(errno) << std::endl;
+            break;
+        }
+        if (fds[1].revents & POLLIN) {
+            char buffer[256];
+            while (read(wake_fds[0], buffer, sizeof(buffer)) > 0) {
+            }
+        }
+        if (fds[0].revents & POLLIN)
+            accept_client();
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 2; i < fds.size(); i++) {
+            auto it = clients.find(fds[i].fd);
+            if (it == clients.end() || fds[i].revents == 0)
+                continue;
+            bool ok = true;
+            if (fds[i].revents & (POLLIN | POLLHUP | POLLERR))
+                ok = read_client(it->second);
+            if (ok && (fds[i].revents & POLLOUT))
+                ok = write_client(it->second);
+            if (!ok) {
+                std::cout << "--- Client " << it->first << " disconnected, "
+                          << it->second.n_sent << " frames sent, "
+                          << it->second.n_dropped << " dropped." << std::endl;
+                close(it->first);
+                clients.erase(it);
+            }
+        }
+    }
+}
+
+void StreamServer::accept_client() {
+    while (true) {
+        int fd = accept(listen_fd, nullptr, nullptr);
+        if (fd < 0)
+            return;
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        StreamClient client{};
+        client.fd = fd;
+        client.view_version = 0;
+        set_viewport(client, 0, 0, rows, cols);
+        std::lock_guard<std::mutex> lock(mutex);
+        clients[fd] = client;
+        std::cout << "--- Client " << fd << " connected." << std::endl;
+    }
+}
+
+void StreamServer::set_viewport(StreamClient &client, int row, int col,
+                                int height, int width) {
+    row = std::max(0, std::min(row, rows - 1));
+    col = std::max(0, std::min(col, cols - 1));
+    height = std::max(1, std::min(height, rows - row));
+    width = std::max(1, std::min(width, cols - col));
+    client.tr0 = row / STREAM_TILE_SIZE;
+    client.tc0 = col / STREAM_TILE_SIZE;
+    client.tr1 = (row + height - 1) / STREAM_TILE_SIZE + 1;
+    client.tc1 = (col + width - 1) / STREAM_TILE_SIZE + 1;
+    client.view_version++;
+    client.needs_key = true;
+}
+
+bool StreamServer::read_client(StreamClient &client) {
+    char buffer[1024];
+    ssize_t n = recv(client.fd, buffer, sizeof(buffer), 0);
+    if (n == 0)
+        return false;
+    if (n < 0)
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    client.input.append(buffer, n);
+    size_t end;
+    while ((end = client.input.find('\n')) != std::string::npos) {
+        std::istringstream line(client.input.substr(0, end));
+        client.input.erase(0, end + 1);
+        std::string command;
+        line >> command;
+        if (command == "VIEW") {
+            int row, col, height, width;
+            if (line >> row >> col >> height >> width)
+                set_viewport(client, row, col, height, width);
+        } else if (command == "KEY") {
+            client.view_version++;
+            client.needs_key = true;
+        }
+    }
+    // Commands are short, anything else is not a client of this server.
+    return client.input.size() < 1024;
+}
+
+bool StreamServer::write_client(StreamClient &client) {
+    while (!client.queue.empty()) {
+        iovec iov[64];
+        int n_iov = 0;
+        size_t blob_index = client.blob_index;
+        size_t offset = client.offset;
+        for (auto &frame : client.queue) {
+            for (; blob_index < frame.blobs.size() && n_iov < 64;
+                 blob_index++) {
+                const std::vector<uint8_t> &blob = *frame.blobs[blob_index];
+                iov[n_iov].iov_base = (void *)(blob.data() + offset);
+                iov[n_iov].iov_len = blob.size() - offset;
+                n_iov++;
+                offset = 0;
+            }
+            if (n_iov == 64)
+                break;
+            blob_index = 0;
+        }
+        size_t total = 0;
+        for (int i = 0; i < n_iov; i++)
+            total += iov[i].iov_len;
+        msghdr message{};
+        message.msg_iov = iov;
+        message.msg_iovlen = n_iov;
+        ssize_t n = sendmsg(client.fd, &message, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0)
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        // Advance over the bytes that were sent.
+        size_t sent = n;
+        while (sent > 0) {
+            StreamFrame &frame = client.queue.front();
+            size_t left =
+                frame.blobs[client.blob_index]->size() - client.offset;
+            if (sent < left) {
+                client.offset += sent;
+                break;
+            }
+            sent -= left;
+            client.blob_index++;
+            client.offset = 0;
+            if (client.blob_index == frame.blobs.size()) {
+                client.queue.pop_front();
+                client.blob_index = 0;
+                client.n_sent++;
+            }
+        }
+        // A short write means the socket buffer is full.
+        if ((size_t)n < total)
+            break;
+    }
+    return true;
+}
+
+int StreamServer::get_n_clients() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return clients.size();
+}
+
+long StreamServer::get_n_frames() const { return sequence; }
+
+long StreamServer::get_n_dropped() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return n_dropped;
+}
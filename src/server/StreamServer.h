@@ -0,0 +1,123 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#ifndef GAMEOFLIFE_STREAMSERVER_H
+#define GAMEOFLIFE_STREAMSERVER_H
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef std::shared_ptr<const std::vector<uint8_t>> Blob;
+
+// A frame as queued for one client: its own header followed by tile
+// records that are shared with every other client that receives them.
+typedef struct {
+    std::vector<Blob> blobs;
+} StreamFrame;
+
+typedef struct {
+    int fd;
+    std::string input;
+    // Viewport in tiles, rows [tr0, tr1) and columns [tc0, tc1).
+    int tr0, tc0, tr1, tc1;
+    // Incremented when the viewport changes, so a frame encoded for the
+    // old viewport is not queued.
+    int view_version;
+    // Set for new clients, after a viewport change and after a dropped
+    // frame; the next frame then carries all tiles as TILE_KEY.
+    bool needs_key;
+    std::deque<StreamFrame> queue;
+    // Position of the first unsent byte in queue.front().
+    size_t blob_index;
+    size_t offset;
+    long n_sent;
+    long n_dropped;
+} StreamClient;
+
+// Streams generations over TCP to any number of clients, see StreamCodec.h
+// for the format. publish() encodes every tile once and queues the same
+// buffers for all clients; a network thread writes them out with
+// non-blocking sockets. When the queue of a client is full the frame is
+// dropped for that client, which then gets a key frame, so a slow client
+// never blocks the simulation. A client selects its viewport with the line
+// "VIEW <row> <col> <height> <width>".
+class StreamServer {
+  public:
+    StreamServer(int rows, int cols, int port, int max_queue);
+
+    virtual ~StreamServer();
+
+    // Returns false if the port cannot be opened.
+    bool start();
+
+    void publish(int **xt, long generation);
+
+    int get_n_clients();
+
+    long get_n_frames() const;
+
+    long get_n_dropped();
+
+  private:
+    int rows;
+    int cols;
+    int port;
+    size_t max_queue;
+    int tile_rows;
+    int tile_cols;
+    int listen_fd;
+    int wake_fds[2];
+    bool stopping;
+    std::thread network;
+    std::mutex mutex;
+    std::map<int, StreamClient> clients;
+    long n_dropped;
+    int sequence;
+    // Tiles of the current and the previous frame, STREAM_TILE_SIZE words
+    // each, and the sequence number of the frame in prev, -1 if it is not
+    // valid.
+    std::vector<uint64_t> tiles;
+    std::vector<uint64_t> prev_tiles;
+    std::vector<int> prev_sequence;
+    std::vector<long> tile_population;
+
+    void run();
+
+    void accept_client();
+
+    bool read_client(StreamClient &client);
+
+    bool write_client(StreamClient &client);
+
+    void set_viewport(StreamClient &client, int row, int col, int height,
+                      int width);
+
+    void wake();
+
+    int tile_h(int tr) const;
+
+    int tile_w(int tc) const;
+
+    void pack_tile(int **xt, int t);
+
+    Blob encode_tile(int t, int kind) const;
+};
+
+#endif
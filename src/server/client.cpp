@@ -0,0 +1,262 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+// Reference client of game-of-life-server. It subscribes to a viewport,
+// rebuilds the tiles from the key and delta frames and checks every frame
+// against the population sent by the server.
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <netdb.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "StreamCodec.h"
+
+static std::string host = "127.0.0.1";
+static std::string port = "7777";
+static int view[4] = {0, 0, 0, 0};
+static long n_frames = 100;
+static int delay_ms = 0;
+static bool print_view = false;
+
+int parse_arguments(std::vector<std::string> args) {
+    for (auto i = args.begin(); i != args.end(); ++i) {
+        if (*i == "-h" || *i == "--help") {
+            std::cout << "game-of-life-client" << std::endl;
+            std::cout << "   --host <name>         : server, "
+                         "default = 127.0.0.1."
+                      << std::endl;
+            std::cout << "   --port <number>       : port of the server, "
+                         "default = 7777."
+                      << std::endl;
+            std::cout << "   --view <r> <c> <h> <w>: viewport in cells, "
+                         "default = the whole domain."
+                      << std::endl;
+            std::cout << "   --frames <number>     : frames to receive, "
+                         "default = 100."
+                      << std::endl;
+            std::cout << "   --delay <ms>          : wait after each frame, to "
+                         "act as a slow client, default = 0."
+                      << std::endl;
+            std::cout << "   --print               : print the viewport after "
+                         "the last frame."
+                      << std::endl;
+            std::cout << "   -h, --help            : info and help message."
+                      << std::endl;
+            exit(0);
+        } else if (*i == "--host") {
+            host = *++i;
+        } else if (*i == "--port") {
+            port = *++i;
+        } else if (*i == "--view") {
+            for (int k = 0; k < 4; k++)
+                view[k] = stoi(*++i);
+        } else if (*i == "--frames") {
+            n_frames = stol(*++i);
+        } else if (*i == "--delay") {
+            delay_ms = stoi(*++i);
+        } else if (*i == "--print") {
+            print_view = true;
+        } else {
+            std::cout << "Unknown argument: " << *i << std::endl;
+            exit(1);
+        }
+    }
+    return 0;
+}
+
+static bool read_exact(int fd, uint8_t *buffer, size_t n) {
+    while (n > 0) {
+        ssize_t k = recv(fd, buffer, n, 0);
+        if (k <= 0)
+            return false;
+        buffer += k;
+        n -= k;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    std::vector<std::string> args(argv + 1, argv + argc);
+    parse_arguments(args);
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *addresses;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) != 0) {
+        std::cerr << "Unknown host: " << host << std::endl;
+        exit(1);
+    }
+    int fd = -1;
+    for (addrinfo *a = addresses; a != nullptr; a = a->ai_next) {
+        fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd >= 0 && connect(fd, a->ai_addr, a->ai_addrlen) == 0)
+            break;
+        if (fd >= 0)
+            close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(addresses);
+    if (fd < 0) {
+        std::cerr << "Can't connect to " << host << ":" << port << std::endl;
+        exit(1);
+    }
+    if (view[2] > 0 && view[3] > 0) {
+        std::string command = "VIEW " + std::to_string(view[0]) + " " +
+                              std::to_string(view[1]) + " " +
+                              std::to_string(view[2]) + " " +
+                              std::to_string(view[3]) + "\n";
+        if (send(fd, command.data(), command.size(), 0) < 0) {
+            std::cerr << "send: " << strerror(errno) << std::endl;
+            exit(1);
+        }
+    }
+
+    int rows = 0, cols = 0, tile_rows = 0, tile_cols = 0;
+    // Tiles of the viewport, which the population sent by the server
+    // covers.
+    int tr0 = 0, tc0 = 0, tr1 = 0, tc1 = 0;
+    std::vector<uint64_t> tiles;
+    std::vector<bool> received;
+    long n_bytes = 0, n_missed = 0, n_errors = 0, n_keys = 0;
+    long first_sequence = -1, last_sequence = -1, generation = 0;
+    uint8_t header[STREAM_FRAME_HEADER_SIZE];
+    std::vector<uint8_t> payload;
+    uint8_t bytes[STREAM_TILE_SIZE * 8];
+    auto t0 = std::chrono::steady_clock::now();
+    long frame = 0;
+    for (; frame < n_frames; frame++) {
+        if (!read_exact(fd, header, sizeof(header)))
+            break;
+        if (get_u32(header) != STREAM_MAGIC) {
+            std::cerr << "Not a frame stream." << std::endl;
+            exit(1);
+        }
+        long sequence = (int32_t)get_u32(header + 4);
+        generation = get_u64(header + 8);
+        if (rows == 0) {
+            rows = get_u32(header + 16);
+            cols = get_u32(header + 20);
+            tile_rows = (rows + STREAM_TILE_SIZE - 1) / STREAM_TILE_SIZE;
+            tile_cols = (cols + STREAM_TILE_SIZE - 1) / STREAM_TILE_SIZE;
+            tiles.assign((size_t)tile_rows * tile_cols * STREAM_TILE_SIZE, 0);
+            received.assign(tile_rows * tile_cols, false);
+            tr1 = tile_rows;
+            tc1 = tile_cols;
+            if (view[2] > 0 && view[3] > 0) {
+                // Clamped to the domain as the server does.
+                int row = std::max(0, std::min(view[0], rows - 1));
+                int col = std::max(0, std::min(view[1], cols - 1));
+                int height = std::min(view[2], rows - row);
+                int width = std::min(view[3], cols - col);
+                tr0 = row / STREAM_TILE_SIZE;
+                tc0 = col / STREAM_TILE_SIZE;
+                tr1 = (row + height - 1) / STREAM_TILE_SIZE + 1;
+                tc1 = (col + width - 1) / STREAM_TILE_SIZE + 1;
+            }
+        }
+        int n_tiles = get_u32(header + 28);
+        long population = get_u64(header + 32);
+        if (first_sequence < 0)
+            first_sequence = sequence;
+        else
+            n_missed += sequence - last_sequence - 1;
+        last_sequence = sequence;
+        n_bytes += sizeof(header);
+        bool key = false;
+        for (int k = 0; k < n_tiles; k++) {
+            uint8_t tile_header[STREAM_TILE_HEADER_SIZE];
+            if (!read_exact(fd, tile_header, sizeof(tile_header)))
+                exit(1);
+            int tr = get_u32(tile_header);
+            int tc = get_u32(tile_header + 4);
+            int kind = tile_header[8];
+            int h = tile_header[9];
+            uint32_t length = get_u32(tile_header + 12);
+            payload.resize(length);
+            if (!read_exact(fd, payload.data(), length))
+                exit(1);
+            n_bytes += sizeof(tile_header) + length;
+            if (tr >= tile_rows || tc >= tile_cols || h > STREAM_TILE_SIZE ||
+                !rle_decode(payload.data(), length, bytes, h * 8)) {
+                std::cerr << "Corrupt tile in frame " << sequence << std::endl;
+                exit(1);
+            }
+            int t = tr * tile_cols + tc;
+            uint64_t *tile = &tiles[(size_t)t * STREAM_TILE_SIZE];
+            for (int r = 0; r < h; r++) {
+                uint64_t word = get_u64(bytes + r * 8);
+                tile[r] = kind == TILE_DELTA ? tile[r] ^ word : word;
+            }
+            received[t] = true;
+            key = key || kind == TILE_KEY;
+        }
+        n_keys += key;
+        // The first frames may still cover the whole domain, sent before
+        // the server read VIEW, so only the tiles of the viewport count.
+        long counted = 0;
+        for (int tr = tr0; tr < tr1; tr++) {
+            for (int tc = tc0; tc < tc1; tc++) {
+                int t = tr * tile_cols + tc;
+                if (received[t])
+                    for (int r = 0; r < STREAM_TILE_SIZE; r++)
+                        counted += __builtin_popcountll(
+                            tiles[(size_t)t * STREAM_TILE_SIZE + r]);
+            }
+        }
+        if (counted != population) {
+            std::cerr << "Frame " << sequence << ": population " << counted
+                      << ", server sent " << population << std::endl;
+            n_errors++;
+        }
+        if (delay_ms > 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(t1 - t0).count();
+    close(fd);
+
+    if (print_view && rows > 0) {
+        int r0 = view[2] > 0 ? view[0] : 0;
+        int c0 = view[3] > 0 ? view[1] : 0;
+        int r1 = view[2] > 0 ? std::min(rows, r0 + view[2]) : rows;
+        int c1 = view[3] > 0 ? std::min(cols, c0 + view[3]) : cols;
+        for (int r = r0; r < r1; r++) {
+            for (int c = c0; c < c1; c++) {
+                int t = (r / STREAM_TILE_SIZE) * tile_cols +
+                        c / STREAM_TILE_SIZE;
+                uint64_t word = tiles[(size_t)t * STREAM_TILE_SIZE +
+                                      r % STREAM_TILE_SIZE];
+                std::cout << ((word >> (c % STREAM_TILE_SIZE)) & 1 ? '#'
+                                                                   : '.');
+            }
+            std::cout << std::endl;
+        }
+    }
+    std::cout << "[ frames: " << frame << " ]-";
+    std::cout << "[ generation: " << generation << " ]-";
+    std::cout << "[ missed: " << n_missed << " ]-";
+    std::cout << "[ key frames: " << n_keys << " ]-";
+    std::cout << "[ bytes/frame: " << (frame > 0 ? n_bytes / frame : 0)
+              << " ]-";
+    std::cout << "[ errors: " << n_errors << " ]-";
+    std::cout << "[ time: " << seconds << " s ]" << std::endl;
+    exit(n_errors > 0 ? 1 : 0);
+}
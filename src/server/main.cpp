@@ -0,0 +1,193 @@
+//   Copyright 2023 Gilbert Francois Duivesteijn
+//
+//   Licensed under the Apache License, Version 2.0 (the "License");
+//   you may not use this file except in compliance with the License.
+//   You may obtain a copy of the License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the License is distributed on an "AS IS" BASIS,
+//   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//   See the License for the specific language governing permissions and
+//   limitations under the License.
+//
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "StreamServer.h"
+#include "main.h"
+
+static int port = 7777;
+// Frames queued per client before frames are dropped for it.
+static int max_queue = 4;
+// Published frames per second, 0 = as fast as the kernel runs.
+static double fps = 30;
+static volatile std::sig_atomic_t interrupted = 0;
+
+static void on_signal(int) { interrupted = 1; }
+
+int parse_arguments(std::vector<std::string> args, Config *config) {
+    for (auto i = args.begin(); i != args.end(); ++i) {
+        if (*i == "-h" || *i == "--help") {
+            std::cout << "game-of-life-server" << std::endl;
+            std::cout << "   --width <number>      : width of the domain, "
+                         "default = 1024."
+                      << std::endl;
+            std::cout << "   --height <number>     : height of the domain, "
+                         "default = 1024."
+                      << std::endl;
+            std::cout << "   --steps <number>      : number of steps, 0=until "
+                         "interrupted, default = 0."
+                      << std::endl;
+            std::cout << "   --bt <number>         : boundary type: 0=const, "
+                         "1=periodic, 2=mirror, default=1."
+                      << std::endl;
+            std::cout << "   --seed <number>       : seed of the initial "
+                         "conditions, 0=random, default = 0."
+                      << std::endl;
+            std::cout << "   --kernel <number>     : kernel variant: 0=generic, "
+                         "1=specialized, default=1."
+                      << std::endl;
+            std::cout << "   --density <number>    : fraction of live cells in "
+                         "the initial conditions, default = 0.5."
+                      << std::endl;
+            std::cout << "   --sparse <number>     : density below which only "
+                         "the live cells are stepped, 0=never, default = 0.01."
+                      << std::endl;
+            std::cout << "   --port <number>       : TCP port to listen on, "
+                         "default = 7777."
+                      << std::endl;
+            std::cout << "   --fps <number>        : frames per second sent to "
+                         "the clients, 0=unlimited, default = 30."
+                      << std::endl;
+            std::cout << "   --every <number>      : send every n-th "
+                         "generation, default = 1."
+                      << std::endl;
+            std::cout << "   --queue <number>      : frames queued per client "
+                         "before frames are dropped for it, default = 4."
+                      << std::endl;
+            std::cout << "   --without-threads     : compute single threaded."
+                      << std::endl;
+            std::cout << "   --with-threads        : compute multi-threaded."
+                      << std::endl;
+            std::cout << "   -h, --help            : info and help message."
+                      << std::endl;
+            exit(0);
+        } else if (*i == "--width") {
+            config->cols = stoi(*++i);
+        } else if (*i == "--height") {
+            config->rows = stoi(*++i);
+        } else if (*i == "--steps") {
+            config->n_steps = stoi(*++i);
+        } else if (*i == "--bt") {
+            config->boundary_type = stoi(*++i);
+        } else if (*i == "--seed") {
+            config->seed = stoul(*++i);
+        } else if (*i == "--kernel") {
+            config->kernel_variant = stoi(*++i);
+        } else if (*i == "--density") {
+            config->density = stof(*++i);
+        } else if (*i == "--sparse") {
+            config->sparse_density = stof(*++i);
+        } else if (*i == "--port") {
+            port = stoi(*++i);
+        } else if (*i == "--fps") {
+            fps = stod(*++i);
+        } else if (*i == "--every") {
+            config->export_every = stoi(*++i);
+        } else if (*i == "--queue") {
+            max_queue = stoi(*++i);
+        } else if (*i == "--without-threads") {
+            config->with_threads = false;
+        } else if (*i == "--with-threads") {
+            config->with_threads = true;
+        } else {
+            std::cout << "Unknown argument: " << *i << std::endl;
+            exit(1);
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    // Initialize default values
+    Config config{};
+    config.rows = 1024;
+    config.cols = 1024;
+    config.n_steps = 0;
+    config.boundary_type = BOUNDARY_PERIODIC;
+    config.display_w = 0;
+    config.display_h = 0;
+    config.zoom_factor = 1;
+    config.with_threads = true;
+    config.mode_fullscreen = false;
+    config.on_cycle = CYCLE_CONTINUE;
+    config.ensemble_size = 0;
+    config.seed = 0;
+    config.kernel_variant = KERNEL_SPECIALIZED;
+    config.density = 0.5;
+    config.sparse_density = 0.01;
+    config.quiet = false;
+    config.headless = true;
+    config.export_format = 0;
+    config.export_every = 1;
+    config.history_mb = 0;
+    config.n_threads = 0;
+    config.tile_h = 0;
+    config.tile_w = 0;
+    config.autotune = AUTOTUNE_OFF;
+    config.step_ahead = 0;
+    config.density_pyramid = false;
+    config.zoom_out = 1;
+    // Parse arguments
+    std::vector<std::string> args(argv + 1, argv + argc);
+    parse_arguments(args, &config);
+    if (config.boundary_type == BOUNDARY_UNBOUNDED) {
+        // The stream has a fixed size, so only the viewport would be sent.
+        std::cout << "--- Unbounded domains can't be streamed." << std::endl;
+        exit(1);
+    }
+    if (config.export_every < 1)
+        config.export_every = 1;
+    StreamServer *server =
+        new StreamServer(config.rows, config.cols, port, max_queue);
+    if (!server->start())
+        exit(1);
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+    GameOfLifeKernel *kernel = new GameOfLifeKernel(config);
+    std::cout << "--- Streaming " << config.cols << "x" << config.rows
+              << " on port " << port << "." << std::endl;
+    auto t0 = std::chrono::steady_clock::now();
+    auto next_frame = t0;
+    auto frame_time = std::chrono::duration_cast<
+        std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(fps > 0 ? 1.0 / fps : 0.0));
+    // Game loop.
+    for (long i = 0; !interrupted && (config.n_steps <= 0 || i < config.n_steps);
+         i++) {
+        if (i % config.export_every == 0) {
+            server->publish(kernel->get_xt(), kernel->get_generation());
+            if (fps > 0) {
+                next_frame += frame_time;
+                std::this_thread::sleep_until(next_frame);
+            }
+        }
+        kernel->timestep();
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(t1 - t0).count();
+    std::cout << "[ steps: " << kernel->get_generation() << " ]-";
+    std::cout << "[ frames: " << server->get_n_frames() << " ]-";
+    std::cout << "[ dropped: " << server->get_n_dropped() << " ]-";
+    std::cout << "[ population: " << kernel->get_population() << " ]-";
+    std::cout << "[ time: " << seconds << " s ]" << std::endl;
+    delete server;
+    delete kernel;
+    exit(0);
+}